@@ -0,0 +1,24 @@
+// appends 1e6 elements to an array with +=, then removes and concatenates in place
+
+int count = 1000000;
+arr numbers = array() int;
+
+int start = timestamp();
+int i = 0;
+for (; i < count; i += 1) {
+  numbers += i;
+}
+println("append:", count, "elements in", timestamp() - start, "ms");
+
+start = timestamp();
+arr doubled = array() int;
+doubled ^= numbers;
+doubled ^= numbers;
+println("concat:", size(doubled), "elements in", timestamp() - start, "ms");
+
+start = timestamp();
+int last = size(doubled) - 1;
+for (; last >= count; last -= 1) {
+  doubled -= last;
+}
+println("remove:", count, "elements from the back in", timestamp() - start, "ms");
@@ -0,0 +1,41 @@
+// transform, filter and reduce drive the loop natively, against the same loops written in Ckript
+
+int count = 1000000;
+arr numbers = array() int;
+int i = 0;
+for (; i < count; i += 1) {
+  numbers += i;
+}
+
+int start = timestamp();
+arr doubled = array() int;
+for (i = 0; i < size(numbers); i += 1) {
+  doubled += numbers[i] * 2;
+}
+println("loop: transform", count, "ints in", timestamp() - start, "ms");
+
+start = timestamp();
+arr doubled2 = transform(numbers, function(int x) int { return x * 2; });
+println("native: transform", count, "ints in", timestamp() - start, "ms");
+
+start = timestamp();
+arr evens = array() int;
+for (i = 0; i < size(numbers); i += 1) {
+  if (numbers[i] % 2 == 0) evens += numbers[i];
+}
+println("loop: filter", count, "ints in", timestamp() - start, "ms");
+
+start = timestamp();
+arr evens2 = filter(numbers, function(int x) bool { return x % 2 == 0; });
+println("native: filter", count, "ints in", timestamp() - start, "ms");
+
+start = timestamp();
+int total = 0;
+for (i = 0; i < size(numbers); i += 1) {
+  total += numbers[i];
+}
+println("loop: reduce", count, "ints in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+int total2 = reduce(numbers, function(int acc, int x) int { return acc + x; }, 0);
+println("native: reduce", count, "ints in", timestamp() - start, "ms, total =", total2);
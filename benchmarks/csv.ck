@@ -0,0 +1,29 @@
+// loading a csv file with csv_read() against file_read() + split() + to_int()/to_double()
+
+str path = "/tmp/ckript_csv_bench.csv";
+int rows = 200000;
+builder b = builder_new();
+builder_append(b, "id,price,name\n");
+int i = 0;
+for (; i < rows; i += 1) {
+  builder_append(b, i, ",", to_double(i % 1000) / 8.0, ",item", i % 97, "\n");
+}
+file_write(path, builder_str(b));
+
+int start = timestamp();
+arr lines = split(file_read(path), "\n");
+arr ids = array() [rows] int;
+arr prices = array() [rows] double;
+i = 1;
+for (; i < size(lines); i += 1) {
+  arr fields = split(lines[i], ",");
+  #ids[i - 1] = to_int(fields[0]);
+  #prices[i - 1] = to_double(fields[1]);
+}
+println("split:", timestamp() - start, "ms", sum(ids), sum(prices));
+
+start = timestamp();
+obj table = csv_read(path, array("id:int", "price:double", "name:str") str);
+println("csv_read:", timestamp() - start, "ms", sum(table.id), sum(table.price), size(table.name));
+
+file_remove(path);
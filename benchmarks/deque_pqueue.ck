@@ -0,0 +1,58 @@
+// prepending to an array against a deque, and picking the smallest element of an array against a priority queue
+
+int count = 50000;
+
+int start = timestamp();
+arr items = array() int;
+int i = 0;
+for (; i < count; i += 1) {
+  items = i + items;
+}
+println("arrays:", count, "prepends in", timestamp() - start, "ms");
+
+start = timestamp();
+deque d = deque_new();
+for (i = 0; i < count; i += 1) {
+  deque_push_front(d, i);
+}
+println("deque:", count, "prepends in", timestamp() - start, "ms");
+
+count = 1000;
+start = timestamp();
+arr pending = array() int;
+for (i = 0; i < count; i += 1) {
+  pending += (i * 7919) % count;
+}
+int total = 0;
+while (size(pending) > 0) {
+  int best = 0;
+  int j = 1;
+  for (; j < size(pending); j += 1) {
+    if (pending[j] < pending[best]) best = j;
+  }
+  total += pending[best];
+  pending -= best;
+}
+println("arrays:", count, "pops of the smallest element in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+pqueue q = pqueue_new();
+for (i = 0; i < count; i += 1) {
+  pqueue_push(q, (i * 7919) % count);
+}
+total = 0;
+while (size(q) > 0) {
+  total += pqueue_pop(q);
+}
+println("pqueue:", count, "pops of the smallest element in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+pqueue by_cmp = pqueue_new(function(int a, int b) bool { return a > b; });
+for (i = 0; i < count; i += 1) {
+  pqueue_push(by_cmp, (i * 7919) % count);
+}
+total = 0;
+while (size(by_cmp) > 0) {
+  total += pqueue_pop(by_cmp);
+}
+println("pqueue with a comparator:", count, "pops of the biggest element in", timestamp() - start, "ms, total =", total);
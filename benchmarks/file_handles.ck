@@ -0,0 +1,48 @@
+// writing a file piece by piece through a handle against building it in memory for file_write()
+
+str path = "/tmp/ckript_handles_bench.txt";
+int lines = 300000;
+
+int start = timestamp();
+builder b = builder_new();
+int i = 0;
+for (; i < lines; i += 1) {
+  builder_append(b, "line ", i, "\n");
+}
+file_write(path, builder_str(b));
+println("builder + file_write:", timestamp() - start, "ms");
+
+start = timestamp();
+int h = file_open(path, "w");
+i = 0;
+for (; i < lines; i += 1) {
+  file_write_chunk(h, "line " + i + "\n");
+}
+file_close(h);
+println("file_write_chunk lines:", timestamp() - start, "ms");
+
+str block = "";
+for (; size(block) < 65536; ) {
+  block += "0123456789abcdef";
+}
+start = timestamp();
+h = file_open(path, "w");
+i = 0;
+for (; i < 4096; i += 1) {
+  file_write_chunk(h, block);
+}
+file_close(h);
+println("file_write_chunk 256 MB:", timestamp() - start, "ms");
+
+start = timestamp();
+h = file_open(path, "r");
+int total = 0;
+str chunk = file_read_chunk(h, 1048576);
+for (; size(chunk) > 0; ) {
+  total += size(chunk);
+  chunk = file_read_chunk(h, 1048576);
+}
+file_close(h);
+println("file_read_chunk:", total, "bytes in", timestamp() - start, "ms");
+
+file_remove(path);
@@ -0,0 +1,22 @@
+// reading a file whole, mapped and line by line
+
+str path = "/tmp/ckript_files_bench.txt";
+builder b = builder_new();
+int i = 0;
+for (; i < 200000; i += 1) {
+  builder_append(b, "line ", i, " of the benchmark file\n");
+}
+file_write(path, builder_str(b));
+
+int start = timestamp();
+str contents = file_read(path);
+println("file_read:", timestamp() - start, "ms,", size(contents), "bytes");
+
+start = timestamp();
+str mapped = file_map(path);
+println("file_map:", timestamp() - start, "ms,", size(mapped), "bytes");
+
+start = timestamp();
+println("file_lines:", stream_count(file_lines(path)), "lines in", timestamp() - start, "ms");
+
+file_remove(path);
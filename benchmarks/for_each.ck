@@ -0,0 +1,33 @@
+// summing an array with an index loop against a for each loop, and counting with a for loop against a range
+
+int count = 1000000;
+arr numbers = stream_collect(range(0, count));
+
+int start = timestamp();
+int total = 0;
+int i = 0;
+for (; i < size(numbers); i += 1) {
+  total += numbers[i];
+}
+println("index loop:", count, "elements in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+total = 0;
+for (int x : numbers) {
+  total += x;
+}
+println("for each:", count, "elements in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+total = 0;
+for (i = 0; i < count; i += 1) {
+  total += i;
+}
+println("counting loop:", count, "iterations in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+total = 0;
+for (int j : range(0, count)) {
+  total += j;
+}
+println("for each over range:", count, "iterations in", timestamp() - start, "ms, total =", total);
@@ -0,0 +1,50 @@
+// native hash map against looking keys up in a pair of arrays from the script
+
+int count = 1000;
+
+int start = timestamp();
+arr keys = array() str;
+arr values = array() int;
+int i = 0;
+for (; i < count; i += 1) {
+  keys += "key" + to_str(i);
+  values += i;
+}
+int total = 0;
+for (i = 0; i < count; i += 1) {
+  str key = "key" + to_str(i);
+  int j = 0;
+  for (; j < size(keys); j += 1) {
+    if (keys[j] == key) {
+      total += values[j];
+      break;
+    }
+  }
+}
+println("arrays:", count, "inserts and lookups in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+map m = map_new();
+for (i = 0; i < count; i += 1) {
+  map_set(m, "key" + to_str(i), i);
+}
+total = 0;
+for (i = 0; i < count; i += 1) {
+  total += map_get(m, "key" + to_str(i));
+}
+println("map:", count, "inserts and lookups in", timestamp() - start, "ms, total =", total);
+
+count = 200000;
+start = timestamp();
+map ints = map_new();
+for (i = 0; i < count; i += 1) {
+  map_set(ints, i * 7, i);
+}
+for (i = 0; i < count; i += 2) {
+  map_remove(ints, i * 7);
+}
+int found = 0;
+for (i = 0; i < count; i += 1) {
+  if (map_has(ints, i * 7)) found += 1;
+}
+println("map:", count, "int inserts, removes and lookups in", timestamp() - start, "ms, found =", found);
@@ -0,0 +1,40 @@
+// deduplicating with a native set against searching the array of unique values from the script
+
+int count = 1000;
+arr numbers = array() int;
+int i = 0;
+for (; i < count; i += 1) {
+  numbers += (i * 7919) % (count / 2);
+}
+
+int start = timestamp();
+arr unique = array() int;
+for (i = 0; i < count; i += 1) {
+  bool seen = false;
+  int j = 0;
+  for (; j < size(unique); j += 1) {
+    if (unique[j] == numbers[i]) {
+      seen = true;
+      break;
+    }
+  }
+  if (!seen) unique += numbers[i];
+}
+println("arrays: deduplicated", count, "ints to", size(unique), "in", timestamp() - start, "ms");
+
+start = timestamp();
+hashset seen = set_new(numbers);
+println("set: deduplicated", count, "ints to", size(seen), "in", timestamp() - start, "ms");
+
+count = 200000;
+start = timestamp();
+hashset evens = set_new();
+hashset thirds = set_new();
+for (i = 0; i < count; i += 1) {
+  if (i % 2 == 0) set_add(evens, i);
+  if (i % 3 == 0) set_add(thirds, i);
+}
+hashset both = set_intersection(evens, thirds);
+hashset either = set_union(evens, thirds);
+hashset only_evens = set_difference(evens, thirds);
+println("set:", size(both), size(either), size(only_evens), "in", timestamp() - start, "ms");
@@ -0,0 +1,26 @@
+// string literals and names are interned, objects built from them share one copy of every string
+
+class Record(
+  str name,
+  str category,
+  str description,
+  int id
+);
+
+int count = 100000;
+
+int start = timestamp();
+arr records = array() obj;
+int i = 0;
+for (; i < count; i += 1) {
+  records += Record("a record with a fairly long name", "some category", "a description that does not fit into a small string buffer", i);
+}
+println("create:", count, "objects in", timestamp() - start, "ms");
+
+start = timestamp();
+int matches = 0;
+i = 0;
+for (; i < count; i += 1) {
+  if (records[i].category == "some category") matches += 1;
+}
+println("compare:", count, "string members in", timestamp() - start, "ms, matches =", matches);
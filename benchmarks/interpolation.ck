@@ -0,0 +1,23 @@
+// formatting log lines with string interpolation, from a literal and from a string built at runtime
+// the time of an empty loop is subtracted, so only the interpolation is measured
+
+int count = 100000;
+int start = timestamp();
+int i = 0;
+for (; i < count; i += 1) {
+  str line = "plain";
+}
+int overhead = timestamp() - start;
+
+start = timestamp();
+for (i = 0; i < count; i += 1) {
+  str line = "[@1] request @2 took @3 ms, @4 bytes sent to @5 (@6)"("info", "GET", "12", "1024", "10.0.0.1", "ok");
+}
+println("literal template:", count, "lines in", timestamp() - start - overhead, "ms");
+
+str format = "[@1] request @2 took @3 ms, " + "@4 bytes sent to @5 (@6)";
+start = timestamp();
+for (i = 0; i < count; i += 1) {
+  str line = format("info", "GET", "12", "1024", "10.0.0.1", "ok");
+}
+println("runtime template:", count, "lines in", timestamp() - start - overhead, "ms");
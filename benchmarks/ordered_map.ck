@@ -0,0 +1,47 @@
+// bucketing timestamps with an ordered map against scanning an array of bucket starts from the script
+
+int buckets = 1000;
+int lookups = 2000;
+
+int start = timestamp();
+arr starts = array() int;
+int i = 0;
+for (; i < buckets; i += 1) {
+  starts += i * 60;
+}
+int total = 0;
+for (i = 0; i < lookups; i += 1) {
+  int t = (i * 7919) % (buckets * 60);
+  int j = size(starts) - 1;
+  for (; j >= 0; j -= 1) {
+    if (starts[j] <= t) break;
+  }
+  total += starts[j];
+}
+println("arrays:", lookups, "bucket lookups in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+omap bucket_map = omap_new();
+for (i = 0; i < buckets; i += 1) {
+  omap_set(bucket_map, i * 60, i);
+}
+total = 0;
+for (i = 0; i < lookups; i += 1) {
+  total += omap_floor(bucket_map, (i * 7919) % (buckets * 60));
+}
+println("omap:", lookups, "bucket lookups in", timestamp() - start, "ms, total =", total);
+
+int count = 200000;
+start = timestamp();
+omap events = omap_new();
+for (i = 0; i < count; i += 1) {
+  omap_set(events, (i * 7919) % 1000003, i);
+}
+for (i = 0; i < count; i += 4) {
+  omap_remove(events, (i * 7919) % 1000003);
+}
+int in_range = 0;
+for (i = 0; i < 1000; i += 1) {
+  in_range += size(omap_range(events, i * 1000, i * 1000 + 100));
+}
+println("omap:", count, "inserts,", count / 4, "removes and 1000 range queries in", timestamp() - start, "ms, in range =", in_range);
@@ -0,0 +1,29 @@
+// int, double and bool arrays are stored unboxed, 8 bytes (or 1 bit) per element
+
+int count = 1000000;
+
+int start = timestamp();
+arr ints = array() [count] int;
+arr doubles = array() [count] double;
+arr bools = array() [count] bool;
+println("allocate: 3 x", count, "elements in", timestamp() - start, "ms");
+
+start = timestamp();
+int i = 0;
+for (; i < count; i += 1) {
+  #ints[i] = i;
+}
+println("write:", count, "ints in", timestamp() - start, "ms");
+
+start = timestamp();
+int total = 0;
+i = 0;
+for (; i < count; i += 1) {
+  total += ints[i];
+}
+println("read:", count, "ints in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+arr bytes = to_bytes(file_read("benchmarks/packed_arrays.ck"));
+str text = from_bytes(bytes);
+println("to_bytes/from_bytes:", size(bytes), "bytes in", timestamp() - start, "ms");
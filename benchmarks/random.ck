@@ -0,0 +1,33 @@
+// monte carlo estimate of pi, one randf() call per coordinate against randf_array()
+
+int count = 200000;
+seed(7);
+
+int start = timestamp();
+int inside = 0;
+int i = 0;
+for (; i < count; i += 1) {
+  double x = randf(0.0, 1.0);
+  double y = randf(0.0, 1.0);
+  if (x * x + y * y < 1.0) {
+    inside += 1;
+  }
+}
+println("randf:", timestamp() - start, "ms, pi ~", 4.0 * to_double(inside) / to_double(count));
+
+start = timestamp();
+arr xs = randf_array(count, 0.0, 1.0);
+arr ys = randf_array(count, 0.0, 1.0);
+int filled = timestamp() - start;
+inside = 0;
+i = 0;
+for (; i < count; i += 1) {
+  if (xs[i] * xs[i] + ys[i] * ys[i] < 1.0) {
+    inside += 1;
+  }
+}
+println("randf_array:", filled, "ms to fill,", timestamp() - start, "ms total, pi ~", 4.0 * to_double(inside) / to_double(count));
+
+start = timestamp();
+arr dice = rand_array(count, 1, 6);
+println("rand_array:", timestamp() - start, "ms for", count, "dice, sum", sum(dice));
@@ -0,0 +1,42 @@
+// scanning a generated log with compiled regular expressions: every match in one big string, and a whole-line match per line
+// replace_all goes through std::regex, so it is timed on the same text for comparison
+
+int count = 100000;
+builder log_text = builder_new();
+int i = 0;
+for (; i < count; i += 1) {
+  if (i % 3 == 0) {
+    builder_append(log_text, "2024-01-15 12:00:", i % 60, " GET /api/items/", i, " 200 ", i % 500, "ms\n");
+  } else {
+    builder_append(log_text, "2024-01-15 12:00:", i % 60, " POST /api/orders 201 ", i % 700, "ms\n");
+  }
+}
+str text = builder_str(log_text);
+println("log size:", size(text), "bytes");
+
+regex durations = regex_compile("\d+ms");
+int start = timestamp();
+arr found = regex_find_all(durations, text);
+println("regex_find_all:", size(found), "matches in", timestamp() - start, "ms");
+
+start = timestamp();
+str replaced = replace_all(text, "\d+ms", "_");
+println("replace_all (std::regex) over the same text:", timestamp() - start, "ms");
+
+regex gets = regex_compile("[0-9-]+ [0-9:]+ GET /api/items/\d+ 200 \d+ms");
+arr lines = split(text, "\n");
+start = timestamp();
+int matching = 0;
+for (str line : lines) {
+  if (regex_match(gets, line)) matching += 1;
+}
+println("regex_match:", matching, "of", size(lines), "lines in", timestamp() - start, "ms");
+
+regex item = regex_compile("GET /api/items/(\d+)");
+start = timestamp();
+int total = 0;
+for (str line : lines) {
+  arr groups = regex_search(item, line);
+  if (size(groups) != 0) total += to_int(groups[1]);
+}
+println("regex_search with a group:", size(lines), "lines in", timestamp() - start, "ms, total =", total);
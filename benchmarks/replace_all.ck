@@ -0,0 +1,19 @@
+// replace_all with a plain substring, which skips the regex engine, and with a regular expression, which is compiled once and cached
+
+int count = 100000;
+str line = "2024-01-15 12:00:01 GET /index.html 200 1532";
+
+int start = timestamp();
+int total = 0;
+int i = 0;
+for (; i < count; i += 1) {
+  total += size(replace_all(line, " ", ","));
+}
+println("literal pattern:", count, "calls in", timestamp() - start, "ms, total length =", total);
+
+start = timestamp();
+total = 0;
+for (i = 0; i < count; i += 1) {
+  total += size(replace_all(line, "[0-9]+", "N"));
+}
+println("regex pattern:", count, "calls in", timestamp() - start, "ms, total length =", total);
@@ -0,0 +1,84 @@
+// whole-array natives against the equivalent hand-written loops
+
+int count = 1000000;
+arr values = array() [count] double;
+int i = 0;
+for (; i < count; i += 1) {
+  #values[i] = to_double(i % 1000) / 7.0;
+}
+
+int start = timestamp();
+double total = 0.0;
+i = 0;
+for (; i < count; i += 1) {
+  total += values[i];
+}
+int loop_time = timestamp() - start;
+start = timestamp();
+double native_total = sum(values);
+println("sum: loop", loop_time, "ms, native", timestamp() - start, "ms", total, native_total);
+
+start = timestamp();
+double product = 0.0;
+i = 0;
+for (; i < count; i += 1) {
+  product += values[i] * values[i];
+}
+loop_time = timestamp() - start;
+start = timestamp();
+double native_product = dot(values, values);
+println("dot: loop", loop_time, "ms, native", timestamp() - start, "ms", product, native_product);
+
+start = timestamp();
+arr roots = array() [count] double;
+i = 0;
+for (; i < count; i += 1) {
+  #roots[i] = sqrt(values[i]);
+}
+loop_time = timestamp() - start;
+start = timestamp();
+arr native_roots = sqrt(values);
+println("sqrt: loop", loop_time, "ms, native", timestamp() - start, "ms");
+
+start = timestamp();
+double largest = values[0];
+i = 0;
+for (; i < count; i += 1) {
+  if (values[i] > largest) largest = values[i];
+}
+loop_time = timestamp() - start;
+start = timestamp();
+double native_largest = max(values);
+println("max: loop", loop_time, "ms, native", timestamp() - start, "ms", largest, native_largest);
+
+// odd length so the scalar tail runs, NaN in a vector lane and in the tail
+int odd = count + 3;
+arr with_nan = array() [odd] double;
+i = 0;
+for (; i < odd; i += 1) {
+  #with_nan[i] = to_double(i % 1000) / 7.0;
+}
+println("odd length: min", min(with_nan), "max", max(with_nan), "sum", sum(with_nan));
+#with_nan[odd - 1] = sqrt(-1.0);
+println("NaN in the tail: min", min(with_nan), "max", max(with_nan));
+#with_nan[odd - 1] = 1.0;
+#with_nan[5] = sqrt(-1.0);
+println("NaN in a lane: min", min(with_nan), "max", max(with_nan));
+
+// int sums wrap around in both paths
+arr big = array(9223372036854775807, 1, 1, 1, 1, 1, 1, 1, 1) int;
+println("wrapping sum:", sum(big), "dot:", dot(big, big));
+
+// the result depends on the order of the additions, both paths add in 8 lanes
+// and print 16.0, adding left to right would give 0.0
+int ordered = 27;
+arr cancel = array() [ordered] double;
+arr ones = array() [ordered] double;
+i = 0;
+for (; i < ordered; i += 1) {
+  if (i % 4 == 0) #cancel[i] = 10000000000000000.0;
+  if (i % 4 == 1 || i % 4 == 3) #cancel[i] = 1.0;
+  if (i % 4 == 2) #cancel[i] = -10000000000000000.0;
+  #ones[i] = 1.0;
+}
+println("order dependent sum:", sum(cancel), "dot:", dot(cancel, ones));
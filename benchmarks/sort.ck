@@ -0,0 +1,47 @@
+// insertion sort written in Ckript against the sort() native, which sorts big arrays on all cores
+
+int count = 1000;
+arr numbers = array() int;
+int i = 0;
+for (; i < count; i += 1) {
+  numbers += (i * 7919) % 10007;
+}
+
+int start = timestamp();
+arr script_sorted = numbers;
+for (i = 1; i < count; i += 1) {
+  int current = script_sorted[i];
+  int j = i - 1;
+  while (j >= 0) {
+    if (script_sorted[j] <= current) break;
+    #script_sorted[j + 1] = script_sorted[j];
+    j -= 1;
+  }
+  #script_sorted[j + 1] = current;
+}
+println("script:", count, "ints in", timestamp() - start, "ms");
+
+start = timestamp();
+arr native_sorted = sort(numbers);
+println("native:", count, "ints in", timestamp() - start, "ms, same result =", native_sorted[0] == script_sorted[0] && native_sorted[count - 1] == script_sorted[count - 1]);
+
+start = timestamp();
+arr by_cmp = sort(numbers, function(int a, int b) bool { return a < b; });
+println("native with a comparator:", count, "ints in", timestamp() - start, "ms");
+
+count = 1000000;
+arr big = array() int;
+for (i = 0; i < count; i += 1) {
+  big += (i * 7919) % 1000003;
+}
+start = timestamp();
+arr big_sorted = sort(big);
+println("native:", count, "ints in", timestamp() - start, "ms");
+
+arr words = array() str;
+for (i = 0; i < 200000; i += 1) {
+  words += to_str((i * 7919) % 1000003);
+}
+start = timestamp();
+arr words_sorted = sort(words);
+println("native:", size(words), "strings in", timestamp() - start, "ms");
@@ -0,0 +1,51 @@
+// ingesting 100 MB from stdin, run it as
+// bin/ckript benchmarks/stdin.ck generate | bin/ckript benchmarks/stdin.ck
+// or redirect a generated file into it, piped timings include waiting for the generator
+
+int numbers = 200000;
+bool generate = false;
+if (size(argv) > 1) {
+  generate = argv[1] == "generate";
+}
+if (generate) {
+  println(numbers);
+  int i = 0;
+  for (; i < numbers; i += 1) {
+    println(i * 7, to_double(i) / 4.0);
+  }
+  str row = "";
+  for (; size(row) < 100; ) {
+    row += "some text of a log line, ";
+  }
+  i = 0;
+  for (; i < 1000000; i += 1) {
+    println(row);
+  }
+  exit(0);
+}
+
+int start = timestamp();
+str header = input();
+if (size(header) == 0) {
+  println("no input, pipe the generated input in");
+  exit(0);
+}
+int count = to_int(header);
+int total = 0;
+double fractions = 0.0;
+int i = 0;
+for (; i < count; i += 1) {
+  total += read_int();
+  fractions += read_double();
+}
+println("read_int + read_double:", count * 2, "numbers in", timestamp() - start, "ms", total, fractions);
+
+start = timestamp();
+arr lines = input_lines();
+println("input_lines:", size(lines), "lines in", timestamp() - start, "ms");
+start = timestamp();
+int bytes = 0;
+for (str line : lines) {
+  bytes += size(line);
+}
+println("for each over the lines:", bytes, "bytes in", timestamp() - start, "ms");
@@ -0,0 +1,19 @@
+// a map, filter and sum pipeline over whole arrays against the same pipeline over a lazy stream
+
+int count = 1000000;
+
+int start = timestamp();
+arr numbers = stream_collect(range(0, count));
+arr squares = transform(numbers, function(int x) int { return x * x % 1000; });
+arr small = filter(squares, function(int x) bool { return x < 100; });
+int total = reduce(small, function(int acc, int x) int { return acc + x; }, 0);
+println("arrays:", count, "elements in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+stream pipeline = stream_filter(stream_map(range(0, count), function(int x) int { return x * x % 1000; }), function(int x) bool { return x < 100; });
+total = stream_sum(pipeline);
+println("stream:", count, "elements in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+arr first = stream_collect(stream_take(stream_filter(range(0, 1000000000000), function(int x) bool { return x % 7919 == 0; }), 10));
+println("stream: first", size(first), "multiples of 7919 out of 1e12 in", timestamp() - start, "ms");
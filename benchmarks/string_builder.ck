@@ -0,0 +1,32 @@
+// building a long string piece by piece: s = s + piece copies the whole string every time,
+// += and builders append in place
+
+int count = 20000;
+
+int start = timestamp();
+str concat = "";
+int i = 0;
+for (; i < count; i += 1) {
+  concat = concat + "line " + to_str(i) + "\n";
+}
+println("s = s + piece:", count, "lines in", timestamp() - start, "ms, size =", size(concat));
+
+start = timestamp();
+str appended = "";
+i = 0;
+for (; i < count; i += 1) {
+  appended += "line ";
+  appended += i;
+  appended += "\n";
+}
+println("s += piece:", count, "lines in", timestamp() - start, "ms, size =", size(appended));
+
+count = 200000;
+start = timestamp();
+builder report = builder_new();
+i = 0;
+for (; i < count; i += 1) {
+  builder_append(report, "line ", i, ": value ", i * 0.5, " and some padding to make it longer\n");
+}
+str result = builder_str(report);
+println("builder:", count, "lines in", timestamp() - start, "ms, size =", size(result));
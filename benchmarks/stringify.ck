@@ -0,0 +1,29 @@
+// turning large nested values and many numbers into text
+
+int count = 200000;
+arr values = array() [count] double;
+int i = 0;
+for (; i < count; i += 1) {
+  #values[i] = to_double(i) / 3.0;
+}
+arr nested = array(values, values, values) arr;
+
+int start = timestamp();
+str text = to_str(nested);
+println("to_str nested arrays:", timestamp() - start, "ms,", size(text), "bytes");
+
+start = timestamp();
+builder b = builder_new();
+i = 0;
+for (; i < count; i += 1) {
+  builder_append(b, values[i], " ");
+}
+println("builder_append doubles:", timestamp() - start, "ms,", size(b), "bytes");
+
+start = timestamp();
+str last = "";
+i = 0;
+for (; i < count; i += 1) {
+  last = "value " + values[i];
+}
+println("string + double:", timestamp() - start, "ms,", last);
@@ -0,0 +1,75 @@
+// dispatching on 16 values with an if/else chain against a switch over dense ints and over strings
+
+int count = 200000;
+arr opcodes = stream_collect(stream_map(range(0, count), function(int i) int { return i % 16; }));
+arr names = array("add", "sub", "mul", "div", "mod", "and", "or", "xor", "shl", "shr", "not", "neg", "inc", "dec", "load", "store") str;
+
+int start = timestamp();
+int total = 0;
+for (int op : opcodes) {
+  if (op == 0) total += 1;
+  else if (op == 1) total += 2;
+  else if (op == 2) total += 3;
+  else if (op == 3) total += 4;
+  else if (op == 4) total += 5;
+  else if (op == 5) total += 6;
+  else if (op == 6) total += 7;
+  else if (op == 7) total += 8;
+  else if (op == 8) total += 9;
+  else if (op == 9) total += 10;
+  else if (op == 10) total += 11;
+  else if (op == 11) total += 12;
+  else if (op == 12) total += 13;
+  else if (op == 13) total += 14;
+  else if (op == 14) total += 15;
+  else total += 16;
+}
+println("if/else chain:", count, "dispatches in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+total = 0;
+for (int op : opcodes) {
+  switch (op) {
+    case 0: total += 1; break;
+    case 1: total += 2; break;
+    case 2: total += 3; break;
+    case 3: total += 4; break;
+    case 4: total += 5; break;
+    case 5: total += 6; break;
+    case 6: total += 7; break;
+    case 7: total += 8; break;
+    case 8: total += 9; break;
+    case 9: total += 10; break;
+    case 10: total += 11; break;
+    case 11: total += 12; break;
+    case 12: total += 13; break;
+    case 13: total += 14; break;
+    case 14: total += 15; break;
+    default: total += 16;
+  }
+}
+println("int switch:", count, "dispatches in", timestamp() - start, "ms, total =", total);
+
+start = timestamp();
+total = 0;
+for (int op : opcodes) {
+  switch (names[op]) {
+    case "add": total += 1; break;
+    case "sub": total += 2; break;
+    case "mul": total += 3; break;
+    case "div": total += 4; break;
+    case "mod": total += 5; break;
+    case "and": total += 6; break;
+    case "or": total += 7; break;
+    case "xor": total += 8; break;
+    case "shl": total += 9; break;
+    case "shr": total += 10; break;
+    case "not": total += 11; break;
+    case "neg": total += 12; break;
+    case "inc": total += 13; break;
+    case "dec": total += 14; break;
+    case "load": total += 15; break;
+    default: total += 16;
+  }
+}
+println("str switch:", count, "dispatches in", timestamp() - start, "ms, total =", total);
@@ -0,0 +1,29 @@
+// split, substr and slice return views into the original string or array instead of copying
+
+int count = 100000;
+builder lines_builder = builder_new();
+int i = 0;
+for (; i < count; i += 1) {
+  builder_append(lines_builder, "2024-01-01 12:00:00 INFO request ", i, " handled by worker ", i % 8, "\n");
+}
+str text = builder_str(lines_builder);
+
+int start = timestamp();
+arr lines = split(text, "\n");
+println("split:", size(lines), "lines in", timestamp() - start, "ms");
+
+start = timestamp();
+int total = 0;
+i = 0;
+for (; i < count; i += 1) {
+  total += size(substr(lines[i], 20, 4));
+}
+println("substr:", count, "times in", timestamp() - start, "ms, total =", total);
+
+arr numbers = array() [1000000] int;
+start = timestamp();
+i = 0;
+for (; i < 1000; i += 1) {
+  total += sum(slice(numbers, i, i + 500000));
+}
+println("slice: 1000 x 500000 elements in", timestamp() - start, "ms");
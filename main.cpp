@@ -1,11 +1,23 @@
 #include <iostream>
+#include <cstring>
 #include "src/interpreter.hpp"
 
 int main(int argc, char *argv[]) {
-  if (argc == 1) {
+  Interpreter interpreter;
+  int first = 1;
+  // options come before the script, everything after it is passed to the script
+  for (; first < argc && std::strncmp(argv[first], "--", 2) == 0; first++) {
+    const std::string option = argv[first];
+    if (option.rfind("--output=", 0) == 0 && OutputBuffer::parse_mode(option.substr(9), interpreter.output_mode, interpreter.output_threshold)) {
+      continue;
+    }
+    std::cout << "Unknown option " << option << " (--output=none|line|full|full:<bytes>)\n";
+    return 1;
+  }
+  if (first == argc) {
     std::cout << "No input files\n";
     return 1;
   }
-  Interpreter().process_file(argv[1], argc - 1, argv + 1);
+  interpreter.process_file(argv[first], argc - first, argv + first);
   return 0;
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <iostream>
+#include <algorithm>
 
 bool Expression::is_operation() const {
   return type == BINARY_OP || type == UNARY_OP || type == FUNC_CALL || type == INDEX;
@@ -25,6 +26,48 @@ void Node::add_children(NodeList &nodes) {
   }
 }
 
+bool SwitchTable::add(std::int64_t label, std::size_t target) {
+  cases++;
+  return int_cases.emplace(label, target).second;
+}
+
+bool SwitchTable::add(std::string_view label, std::size_t target) {
+  cases++;
+  return str_cases.emplace(label, target).second;
+}
+
+// labels that fill at least half of their range are moved to a jump table
+void SwitchTable::build_jumps(void) {
+  if (int_cases.empty()) return;
+  std::int64_t min = INT64_MAX, max = INT64_MIN;
+  for (const auto &label : int_cases) {
+    min = std::min(min, label.first);
+    max = std::max(max, label.first);
+  }
+  const std::uint64_t range = (std::uint64_t)max - (std::uint64_t)min + 1;
+  if (range > int_cases.size() * 2 + 8 || range > (1 << 16)) return;
+  jumps_min = min;
+  jumps.assign(range, default_case);
+  for (const auto &label : int_cases) {
+    jumps[label.first - min] = label.second;
+  }
+  int_cases.clear();
+}
+
+std::size_t SwitchTable::find(std::int64_t value) const {
+  if (!jumps.empty()) {
+    const std::uint64_t offset = (std::uint64_t)value - (std::uint64_t)jumps_min;
+    return offset < jumps.size() ? jumps[offset] : default_case;
+  }
+  const auto it = int_cases.find(value);
+  return it == int_cases.end() ? default_case : it->second;
+}
+
+std::size_t SwitchTable::find(std::string_view value) const {
+  const auto it = str_cases.find(value);
+  return it == str_cases.end() ? default_case : it->second;
+}
+
 void Node::print_nesting(int nest) {
   for (int i = 0; i < nest; i++) {
     std::cout << "  " << std::flush;
@@ -57,6 +100,8 @@ void Statement::print(int nest) {
     if (type == NOP) std::cout << "nop";
     if (type == DECL) std::cout << "decl";
     if (type == BREAK) std::cout << "break";
+    if (type == FOR_EACH) std::cout << "for each";
+    if (type == SWITCH) std::cout << "switch";
     std::cout << " ";
     for (auto &expr_rpns : expressions) {
       std::cout << "(";
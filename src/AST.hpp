@@ -3,8 +3,12 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <memory>
+#include <unordered_map>
 #include <cstdint>
 #include "token.hpp"
+#include "strings.hpp"
 
 class Node;
 class FuncParam;
@@ -18,7 +22,7 @@ typedef std::vector<Expression> ExpressionList;
 class FuncParam {
   public:
     std::string type_name = "int";
-    std::string param_name = "";
+    Symbol param_name;
     bool is_ref = false;
     FuncParam(const std::string &_type, const std::string &_name) 
       : type_name(_type), param_name(_name) {};
@@ -41,7 +45,7 @@ class FuncExpression {
 class ClassStatement {
   public:
     ParamList members;
-    std::string class_name = "";
+    Symbol class_name;
 };
 
 class Expression {
@@ -56,13 +60,13 @@ class Expression {
     FuncCall func_call;
     NodeList index;
     NodeListList array_expressions;
-    std::string array_type;
+    Symbol array_type;
     bool array_holds_refs = false;
     NodeList array_size;
     bool is_negative = false;
     std::int64_t number_literal = 0;
-    std::string string_literal = "";
-    std::string id_name = "";
+    Symbol string_literal;
+    Symbol id_name;
     Token::TokenType op;
     double float_literal = 0.0f;
     bool bool_literal = false;
@@ -88,10 +92,31 @@ class Expression {
     void print(int nest = 0);
 };
 
+// case labels of a switch, built once by the parser
+// every case maps to the index of the statement where the execution starts
+class SwitchTable {
+  public:
+    static constexpr std::size_t NO_CASE = SIZE_MAX;
+    bool string_cases = false;
+    std::size_t cases = 0;
+    std::size_t default_case = NO_CASE;
+    // dense integer labels become a jump table indexed by value - jumps_min
+    std::int64_t jumps_min = 0;
+    std::vector<std::size_t> jumps;
+    std::unordered_map<std::int64_t, std::size_t> int_cases;
+    // string labels are interned, so the views stay valid
+    std::unordered_map<std::string_view, std::size_t> str_cases;
+    bool add(std::int64_t label, std::size_t target);
+    bool add(std::string_view label, std::size_t target);
+    void build_jumps(void);
+    std::size_t find(std::int64_t value) const;
+    std::size_t find(std::string_view value) const;
+};
+
 class Statement {
   public:
     typedef enum stmt_type {
-      IF, RETURN, WHILE, FOR, COMPOUND, EXPR, UNKNOWN, NOP, DECL, CLASS, BREAK, CONTINUE, SET, SET_IDX, NONE
+      IF, RETURN, WHILE, FOR, COMPOUND, EXPR, UNKNOWN, NOP, DECL, CLASS, BREAK, CONTINUE, SET, SET_IDX, FOR_EACH, SWITCH, NONE
     } StmtType;
     StmtType type;
     NodeListList expressions;
@@ -99,7 +124,8 @@ class Statement {
     NodeList statements;
     NodeList indexes;
     ClassStatement class_stmt;
-    std::vector<std::string> obj_members;
+    std::vector<Symbol> obj_members;
+    std::shared_ptr<SwitchTable> switch_table;
     std::uint64_t line = 0;
     std::string *source = nullptr;
     Statement(void) : type(NONE) {}
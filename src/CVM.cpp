@@ -1,6 +1,13 @@
 #include "CVM.hpp"
 #include "utils.hpp"
 #include "error-handler.hpp"
+#include "simd.hpp"
+#include "containers.hpp"
+#include "evaluator.hpp"
+#include "sort.hpp"
+#include "streams.hpp"
+#include "regexp.hpp"
+#include "csv.hpp"
 
 #include <cassert>
 #include <iostream>
@@ -14,13 +21,19 @@
 #include <cstring>
 #include <thread>
 #include <regex>
+#include <algorithm>
 
 #define REG_FN(name, fn)\
   class name : public NativeFunction {\
     public:\
       Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {\
+        if (args.size() == 1 && is_numeric_array(args[0])) {\
+          promote_to_double(args[0]);\
+          Simd::fn(args[0].mut_floats(), args[0].array_size());\
+          return std::move(args[0]);\
+        }\
         if (args.size() != 1 || args[0].type != Utils::FLOAT && args[0].type != Utils::INT) {\
-          ErrorHandler::throw_runtime_error(#fn "() expects one argument (double|int)", line);\
+          ErrorHandler::throw_runtime_error(#fn "() expects one argument (double|int|arr)", line);\
         }\
         Value val(Utils::FLOAT);\
         double arg = args[0].float_value;\
@@ -44,10 +57,285 @@ void StackTrace::push(const std::string &_name, const std::uint64_t &_line, std:
   stack.emplace_back(_line, _name, _source);
 }
 
+// throws std::regex_error for invalid patterns, nothing is cached then
+const std::regex &RegexCache::get(const std::string &pattern) {
+  auto it = index.find(pattern);
+  if (it != index.end()) {
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+  }
+  std::regex compiled(pattern);
+  entries.emplace_front(pattern, std::move(compiled));
+  index.emplace(entries.front().first, entries.begin());
+  if (entries.size() > CAPACITY) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+  return entries.front().second;
+}
+
+Random::Random(void) {
+  std::random_device rd;
+  seed(((std::uint64_t)rd() << 32) ^ rd());
+}
+
+// the state is filled by splitmix64, so similar seeds still give unrelated sequences
+void Random::seed(std::uint64_t value) {
+  for (std::uint64_t &word : state) {
+    value += 0x9e3779b97f4a7c15;
+    std::uint64_t z = value;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    word = z ^ (z >> 31);
+  }
+}
+
+static inline std::uint64_t rotl(std::uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+std::uint64_t Random::next(void) {
+  const std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+  const std::uint64_t t = state[1] << 17;
+  state[2] ^= state[0];
+  state[3] ^= state[1];
+  state[1] ^= state[2];
+  state[0] ^= state[3];
+  state[2] ^= t;
+  state[3] = rotl(state[3], 45);
+  return result;
+}
+
+// Lemire's multiply and reject, no modulo bias and usually no division
+std::int64_t Random::between(std::int64_t lo, std::int64_t hi) {
+  const std::uint64_t range = (std::uint64_t)hi - (std::uint64_t)lo + 1;
+  if (range == 0) return (std::int64_t)next();
+  __uint128_t product = (__uint128_t)next() * range;
+  std::uint64_t low = (std::uint64_t)product;
+  if (low < range) {
+    const std::uint64_t threshold = -range % range;
+    while (low < threshold) {
+      product = (__uint128_t)next() * range;
+      low = (std::uint64_t)product;
+    }
+  }
+  return (std::int64_t)((std::uint64_t)lo + (std::uint64_t)(product >> 64));
+}
+
+double Random::between(double lo, double hi) {
+  return lo + (hi - lo) * ((double)(next() >> 11) * 0x1.0p-53);
+}
+
 bool Value::is_lvalue() const {
   return reference_name.size() != 0;
 }
 
+const Symbol &Value::default_array_type(void) {
+  static const Symbol int_type = "int";
+  return int_type;
+}
+
+void Value::set_array_type(const Symbol &_type, bool holds_refs) {
+  type = Utils::ARR;
+  array_type = _type;
+  packed_type = Utils::UNKNOWN;
+  if (holds_refs) return;
+  const std::string &name = _type;
+  if (name == "int") {
+    packed_type = Utils::INT;
+  } else if (name == "double") {
+    packed_type = Utils::FLOAT;
+  } else if (name == "bool") {
+    packed_type = Utils::BOOL;
+  }
+}
+
+bool Value::is_packed() const {
+  return packed_type != Utils::UNKNOWN;
+}
+
+void Value::unpack(void) {
+  if (!is_packed()) return;
+  const std::size_t size = array_size();
+  auto storage = std::make_shared<ArrayStorage>();
+  storage->values.reserve(size);
+  for (std::size_t i = 0; i < size; i++) {
+    storage->values.push_back(array_at(i));
+  }
+  array_storage = storage;
+  array_offset = 0;
+  is_slice = false;
+  packed_type = Utils::UNKNOWN;
+}
+
+std::size_t Value::array_size() const {
+  if (is_slice) return array_length;
+  if (array_storage == nullptr) return 0;
+  if (packed_type == Utils::INT) return array_storage->ints.size();
+  if (packed_type == Utils::FLOAT) return array_storage->floats.size();
+  if (packed_type == Utils::BOOL) return array_storage->bools.size();
+  return array_storage->values.size();
+}
+
+Value Value::array_at(std::size_t index) const {
+  index += array_offset;
+  if (!is_packed()) return array_storage->values[index];
+  Value val(packed_type);
+  if (packed_type == Utils::INT) {
+    val.number_value = array_storage->ints[index];
+  } else if (packed_type == Utils::FLOAT) {
+    val.float_value = array_storage->floats[index];
+  } else {
+    val.boolean_value = array_storage->bools[index];
+  }
+  return val;
+}
+
+const Value &Value::array_ref(std::size_t index) const {
+  return array_storage->values[array_offset + index];
+}
+
+Value &Value::array_mut(std::size_t index) {
+  return mut_array().values[index];
+}
+
+const std::int64_t *Value::ints() const {
+  return array_storage == nullptr ? nullptr : array_storage->ints.data() + array_offset;
+}
+
+const double *Value::floats() const {
+  return array_storage == nullptr ? nullptr : array_storage->floats.data() + array_offset;
+}
+
+std::int64_t *Value::mut_ints() {
+  return mut_array().ints.data();
+}
+
+double *Value::mut_floats() {
+  return mut_array().floats.data();
+}
+
+ArrayStorage &Value::mut_array(void) {
+  // the storage is copied before it's modified if it's shared with another array or this is a slice of it
+  if (array_storage == nullptr) {
+    array_storage = std::make_shared<ArrayStorage>();
+  } else if (array_storage.use_count() != 1 || is_slice) {
+    auto storage = std::make_shared<ArrayStorage>();
+    const std::size_t from = array_offset;
+    const std::size_t to = from + array_size();
+    if (packed_type == Utils::INT) {
+      storage->ints.assign(array_storage->ints.begin() + from, array_storage->ints.begin() + to);
+    } else if (packed_type == Utils::FLOAT) {
+      storage->floats.assign(array_storage->floats.begin() + from, array_storage->floats.begin() + to);
+    } else if (packed_type == Utils::BOOL) {
+      storage->bools.assign(array_storage->bools.begin() + from, array_storage->bools.begin() + to);
+    } else {
+      storage->values.assign(array_storage->values.begin() + from, array_storage->values.begin() + to);
+    }
+    array_storage = storage;
+  }
+  array_offset = 0;
+  is_slice = false;
+  return *array_storage;
+}
+
+Value Value::slice(std::size_t from, std::size_t length) const {
+  Value res(Utils::ARR);
+  res.array_type = array_type;
+  res.packed_type = packed_type;
+  res.array_storage = array_storage;
+  res.array_offset = array_offset + from;
+  res.array_length = length;
+  res.is_slice = true;
+  return res;
+}
+
+void Value::array_set(std::size_t index, const Value &val) {
+  ArrayStorage &storage = mut_array();
+  if (packed_type == Utils::INT) {
+    storage.ints[index] = val.number_value;
+  } else if (packed_type == Utils::FLOAT) {
+    storage.floats[index] = val.float_value;
+  } else if (packed_type == Utils::BOOL) {
+    storage.bools[index] = val.boolean_value;
+  } else {
+    storage.values[index] = val;
+  }
+}
+
+void Value::array_push(const Value &val) {
+  if (&val == this) {
+    const Value val_cpy = val;
+    array_push(val_cpy);
+    return;
+  }
+  ArrayStorage &storage = mut_array();
+  if (packed_type == Utils::INT) {
+    storage.ints.push_back(val.number_value);
+  } else if (packed_type == Utils::FLOAT) {
+    storage.floats.push_back(val.float_value);
+  } else if (packed_type == Utils::BOOL) {
+    storage.bools.push_back(val.boolean_value);
+  } else {
+    storage.values.push_back(val);
+  }
+}
+
+void Value::array_insert(std::size_t index, const Value &val) {
+  ArrayStorage &storage = mut_array();
+  if (packed_type == Utils::INT) {
+    storage.ints.insert(storage.ints.begin() + index, val.number_value);
+  } else if (packed_type == Utils::FLOAT) {
+    storage.floats.insert(storage.floats.begin() + index, val.float_value);
+  } else if (packed_type == Utils::BOOL) {
+    storage.bools.insert(storage.bools.begin() + index, val.boolean_value);
+  } else {
+    storage.values.insert(storage.values.begin() + index, val);
+  }
+}
+
+void Value::array_erase(std::size_t index) {
+  ArrayStorage &storage = mut_array();
+  if (packed_type == Utils::INT) {
+    storage.ints.erase(storage.ints.begin() + index);
+  } else if (packed_type == Utils::FLOAT) {
+    storage.floats.erase(storage.floats.begin() + index);
+  } else if (packed_type == Utils::BOOL) {
+    storage.bools.erase(storage.bools.begin() + index);
+  } else {
+    storage.values.erase(storage.values.begin() + index);
+  }
+}
+
+void Value::array_append(const Value &other) {
+  if (&other == this) {
+    const Value other_cpy = other;
+    array_append(other_cpy);
+    return;
+  }
+  const std::size_t size = other.array_size();
+  if (size == 0) return;
+  if (is_packed() && other.packed_type == packed_type) {
+    ArrayStorage &storage = mut_array();
+    if (packed_type == Utils::INT) {
+      storage.ints.insert(storage.ints.end(), other.ints(), other.ints() + size);
+    } else if (packed_type == Utils::FLOAT) {
+      storage.floats.insert(storage.floats.end(), other.floats(), other.floats() + size);
+    } else {
+      const auto begin = other.array_storage->bools.begin() + other.array_offset;
+      storage.bools.insert(storage.bools.end(), begin, begin + size);
+    }
+    return;
+  }
+  // one of the arrays holds references, fall back to boxed values
+  unpack();
+  ArrayStorage &storage = mut_array();
+  storage.values.reserve(storage.values.size() + size);
+  for (std::size_t i = 0; i < size; i++) {
+    storage.values.push_back(other.array_at(i));
+  }
+}
+
 bool Variable::is_allocated() const {
   return val.heap_reference != -1;
 }
@@ -86,121 +374,264 @@ void Heap::free(std::int64_t ref) {
   cache.push(ref);
 }
 
-std::string CVM::stringify(Value &val) {
+// nested strings are quoted so their separators can be told apart
+static void append_element(CVM &VM, const Value &val, std::string &out) {
+  const bool quoted = val.type == Utils::STR;
+  if (quoted) out += '"';
+  VM.stringify(val, out);
+  if (quoted) out += '"';
+}
+
+void CVM::stringify(const Value &val, std::string &out) {
   if (val.heap_reference != -1) {
-    if (val.heap_reference >= this->heap.chunks.size()) {
-      return "null";
-    }
-    Value *ptr = this->heap.chunks[val.heap_reference].data;
+    Value *ptr = val.heap_reference >= 0 && (std::size_t)val.heap_reference < this->heap.chunks.size() ? this->heap.chunks[val.heap_reference].data : nullptr;
     if (ptr == nullptr) {
-      return "null";
+      out += "null";
     } else {
-      return "ref to " + stringify(*ptr);
+      out += "ref to ";
+      stringify(*ptr, out);
     }
+    return;
   }
   if (val.type == Utils::STR) {
-    return val.string_value;
-  }
-  if (val.type == Utils::INT) {
-    return std::to_string(val.number_value);
-  }
-  if (val.type == Utils::FLOAT) {
-    return std::to_string(val.float_value);
-  }
-  if (val.type == Utils::FUNC) {
-    std::string str = "function(";
-    int i = 0;
-    for (const auto &param : val.func.params) {
-      str += param.type_name;
-      if (i != val.func.params.size() - 1) {
-        str += ", ";
-      }
-      i++;
+    out += val.string_value.view();
+  } else if (val.type == Utils::INT) {
+    append_number(out, val.number_value);
+  } else if (val.type == Utils::FLOAT) {
+    append_number(out, val.float_value);
+  } else if (val.type == Utils::BOOL) {
+    out += val.boolean_value ? "true" : "false";
+  } else if (val.type == Utils::FUNC) {
+    out += "function(";
+    for (std::size_t i = 0; i < val.func.params.size(); i++) {
+      if (i != 0) out += ", ";
+      out += val.func.params[i].type_name;
     }
     if (val.func.params.empty()) {
-      str += "void";
+      out += "void";
     }
-    str += ") ";
+    out += ") ";
     if (val.func.ret_ref) {
-      str += "ref ";
+      out += "ref ";
     }
-    str += val.func.ret_type;
-    return str;
-  }
-  if (val.type == Utils::BOOL) {
-    return val.boolean_value ? "true" : "false";
-  }
-  if (val.type == Utils::CLASS) {
-    return "class " + val.class_name;
-  }
-  if (val.type == Utils::VOID) {
-    return "void";
-  }
-  if (val.type == Utils::UNKNOWN) {
-    return "null";
-  }
-  if (val.type == Utils::ARR) {
-    std::string str = "array<" + val.array_type + ">(";
-    int i = 0;
-    for (auto &el : val.array_values) {
-      if (el.type == Utils::STR) str += "\"";
-      str += stringify(el);
-      if (el.type == Utils::STR) str += "\"";
-      if (i != val.array_values.size() - 1) {
-        str += ", ";
+    out += val.func.ret_type;
+  } else if (val.type == Utils::CLASS) {
+    out += "class ";
+    out += val.class_name;
+  } else if (val.type == Utils::BUILDER) {
+    out += val.builder();
+  } else if (val.type == Utils::MAP) {
+    out += "map(";
+    const auto &entries = val.hash_map().entries;
+    for (std::size_t i = 0; i < entries.size(); i++) {
+      if (i != 0) out += ", ";
+      append_element(*this, entries[i].key.to_value(), out);
+      out += ": ";
+      append_element(*this, entries[i].value, out);
+    }
+    out += ')';
+  } else if (val.type == Utils::OMAP) {
+    out += "omap(";
+    bool first = true;
+    for (OrderedMap::Position pos = val.ordered_map().begin(); pos.valid(); pos.next()) {
+      if (!first) out += ", ";
+      first = false;
+      append_element(*this, pos.key().to_value(), out);
+      out += ": ";
+      append_element(*this, pos.value(), out);
+    }
+    out += ')';
+  } else if (val.type == Utils::DEQUE) {
+    out += "deque(";
+    const Deque &deque = val.deque();
+    for (std::size_t i = 0; i < deque.size(); i++) {
+      if (i != 0) out += ", ";
+      append_element(*this, deque.at(i), out);
+    }
+    out += ')';
+  } else if (val.type == Utils::STREAM) {
+    out += "stream";
+  } else if (val.type == Utils::REGEX) {
+    out += "regex(";
+    out += val.regex().pattern();
+    out += ')';
+  } else if (val.type == Utils::PQUEUE) {
+    out += "pqueue(size ";
+    append_number(out, (std::int64_t)val.priority_queue().size());
+    out += ')';
+  } else if (val.type == Utils::SET) {
+    out += "hashset(";
+    const auto &entries = val.hash_set().entries;
+    for (std::size_t i = 0; i < entries.size(); i++) {
+      if (i != 0) out += ", ";
+      append_element(*this, entries[i].key.to_value(), out);
+    }
+    out += ')';
+  } else if (val.type == Utils::VOID) {
+    out += "void";
+  } else if (val.type == Utils::UNKNOWN) {
+    out += "null";
+  } else if (val.type == Utils::ARR) {
+    out += "array<";
+    out += val.array_type;
+    out += ">(";
+    const std::size_t size = val.array_size();
+    for (std::size_t i = 0; i < size; i++) {
+      if (i != 0) out += ", ";
+      if (val.packed_type == Utils::INT) {
+        append_number(out, val.ints()[i]);
+      } else if (val.packed_type == Utils::FLOAT) {
+        append_number(out, val.floats()[i]);
+      } else if (val.packed_type == Utils::BOOL) {
+        out += val.array_at(i).boolean_value ? "true" : "false";
+      } else {
+        append_element(*this, val.array_ref(i), out);
       }
-      i++;
     }
-    str += ")";
-    return str;
-  }
-  if (val.type == Utils::OBJ) {
-    std::string str = "object<" + val.class_name + ">(";
-    int i = 0;
+    out += ')';
+  } else if (val.type == Utils::OBJ) {
+    out += "object<";
+    out += val.class_name;
+    out += ">(";
+    bool first = true;
     for (auto &member : val.member_values) {
-      str += member.first + ": ";
-      if (member.second.type == Utils::STR) str += "\"";
-      str += stringify(member.second);
-      if (member.second.type == Utils::STR) str += "\"";
-      if (i != val.member_values.size() - 1) {
-        str += ", ";
-      }
-      i++;
+      if (!first) out += ", ";
+      first = false;
+      out += member.first;
+      out += ": ";
+      append_element(*this, member.second, out);
     }
-    str += ")";
-    return str;
+    out += ')';
   }
-  return "";
 }
 
 // stdlib
 
+static bool is_numeric_array(const Value &val) {
+  return val.type == Utils::ARR && (val.packed_type == Utils::INT || val.packed_type == Utils::FLOAT);
+}
+
+static void promote_to_double(Value &arr) {
+  if (arr.packed_type != Utils::INT) return;
+  const std::size_t size = arr.array_size();
+  auto storage = std::make_shared<ArrayStorage>();
+  storage->floats.resize(size);
+  Simd::convert(arr.ints(), storage->floats.data(), size);
+  arr.set_array_type("double");
+  arr.array_storage = storage;
+  arr.array_offset = 0;
+  arr.is_slice = false;
+}
+
 class NativeInput : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
       if (args.size() != 0) {
         ErrorHandler::throw_runtime_error("input() doesn't take any arguments", line);
       }
-      Value str;
-      str.type = Utils::STR;
-      str.string_value = "";
-      std::getline(std::cin, str.string_value);
+      Value str(Utils::STR);
+      VM.output.before_input();
+      VM.input.read_line(str.string_value.mut());
+      return str;
+    }
+};
+
+class NativeInputall : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 0) {
+        ErrorHandler::throw_runtime_error("input_all() doesn't take any arguments", line);
+      }
+      Value str(Utils::STR);
+      VM.output.before_input();
+      VM.input.read_all(str.string_value.mut());
       return str;
     }
 };
 
+// the rest of the input is read at once, the lines are views into it
+class NativeInputlines : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 0) {
+        ErrorHandler::throw_runtime_error("input_lines() doesn't take any arguments", line);
+      }
+      Value all(Utils::STR);
+      VM.output.before_input();
+      VM.input.read_all(all.string_value.mut());
+      const std::string_view text = all.string_value.view();
+      Value res(Utils::ARR);
+      res.set_array_type("str");
+      std::vector<Value> &lines = res.mut_array().values;
+      lines.reserve(std::count(text.begin(), text.end(), '\n') + 1);
+      std::size_t start = 0;
+      while (start < text.size()) {
+        std::size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) end = text.size();
+        lines.emplace_back(Utils::STR);
+        lines.back().string_value = SharedString(all.string_value, start, end - start);
+        start = end + 1;
+      }
+      return res;
+    }
+};
+
+// the next whitespace separated token of the input, which has to be there
+static std::string_view input_token(const std::string &fn, std::int64_t line, CVM &VM) {
+  VM.output.before_input();
+  std::string_view token;
+  if (!VM.input.read_token(token)) {
+    ErrorHandler::throw_runtime_error(fn + "() reached the end of the input", line);
+  }
+  return token;
+}
+
+class NativeReadint : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 0) {
+        ErrorHandler::throw_runtime_error("read_int() doesn't take any arguments", line);
+      }
+      const std::string_view token = input_token("read_int", line, VM);
+      Value val(Utils::INT);
+      if (!parse_number(token, val.number_value)) {
+        ErrorHandler::throw_runtime_error("read_int() expected an int, got " + std::string(token.substr(0, 64)), line);
+      }
+      return val;
+    }
+};
+
+class NativeReaddouble : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 0) {
+        ErrorHandler::throw_runtime_error("read_double() doesn't take any arguments", line);
+      }
+      const std::string_view token = input_token("read_double", line, VM);
+      Value val(Utils::FLOAT);
+      if (!parse_number(token, val.float_value)) {
+        ErrorHandler::throw_runtime_error("read_double() expected a double, got " + std::string(token.substr(0, 64)), line);
+      }
+      return val;
+    }
+};
+
+// the values are written straight into the output buffer, without a temporary string for each
+static void print_args(std::vector<Value> &args, CVM &VM) {
+  for (std::size_t i = 0; i < args.size(); i++) {
+    if (i != 0) VM.output.append(' ');
+    VM.stringify(args[i], VM.output.data());
+  }
+}
+
 class NativePrint : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
       if (args.size() == 0) {
         ErrorHandler::throw_runtime_error("print() expects at least one argument", line);
       }
-      std::size_t i = 0;
-      const std::size_t end_index = args.size() - 1;
-      for (auto &arg : args) {
-        std::printf("%s%s", VM.stringify(arg).c_str(), i != end_index ? " " : "");
-        i++;
-      }
+      print_args(args, VM);
+      VM.output.written();
       return {Utils::VOID};
     }
 };
@@ -208,13 +639,9 @@ class NativePrint : public NativeFunction {
 class NativePrintln : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
-      std::size_t i = 0;
-      const std::size_t end_index = args.size() - 1;
-      for (auto &arg : args) {
-        std::printf("%s%s", VM.stringify(arg).c_str(), i != end_index ? " " : "");
-        i++;
-      }
-      std::printf("\n");
+      print_args(args, VM);
+      VM.output.append('\n');
+      VM.output.written();
       return {Utils::VOID};
     }
 };
@@ -225,7 +652,7 @@ class NativeFlush : public NativeFunction {
       if (args.size() != 0) {
         ErrorHandler::throw_runtime_error("flush() takes no arguments", line);
       }
-      std::fflush(stdout);
+      VM.output.flush();
       return {Utils::VOID};
     }
 };
@@ -239,9 +666,21 @@ class NativeSize : public NativeFunction {
       Value &arg = args[0];
       Value val(Utils::INT);
       if (arg.type == Utils::ARR) {
-        val.number_value = arg.array_values.size();
+        val.number_value = arg.array_size();
       } else if (arg.type == Utils::STR) {
         val.number_value = arg.string_value.size();
+      } else if (arg.type == Utils::BUILDER) {
+        val.number_value = arg.builder().size();
+      } else if (arg.type == Utils::MAP) {
+        val.number_value = arg.hash_map().size();
+      } else if (arg.type == Utils::SET) {
+        val.number_value = arg.hash_set().size();
+      } else if (arg.type == Utils::OMAP) {
+        val.number_value = arg.ordered_map().size();
+      } else if (arg.type == Utils::DEQUE) {
+        val.number_value = arg.deque().size();
+      } else if (arg.type == Utils::PQUEUE) {
+        val.number_value = arg.priority_queue().size();
       } else {
         ErrorHandler::throw_runtime_error("Cannot get the size of " + VM.stringify(arg), line);
       }
@@ -256,7 +695,7 @@ class NativeTostr : public NativeFunction {
         ErrorHandler::throw_runtime_error("to_str() expects one argument", line);
       }
       Value val(Utils::STR);
-      val.string_value = VM.stringify(args[0]);
+      VM.stringify(args[0], val.string_value.mut());
       return val;
     }
 };
@@ -367,13 +806,26 @@ class NativeFileread : public NativeFunction {
         ErrorHandler::throw_runtime_error("file_read() expects one argument (str)", line);
       }
       Value val(Utils::STR);
-      std::ifstream f(args[0].string_value);
-      if (!f.good()) {
+      if (!read_file(args[0].string_value, val.string_value.mut())) {
         ErrorHandler::throw_runtime_error("couldn't read " + args[0].string_value, line);
       }
-      std::stringstream buffer;
-      buffer << f.rdbuf();
-      val.string_value = buffer.str();
+      return val;
+    }
+};
+
+class NativeFilemap : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::STR) {
+        ErrorHandler::throw_runtime_error("file_map() expects one argument (str)", line);
+      }
+      std::shared_ptr<MappedFile> file = MappedFile::open(args[0].string_value);
+      if (file == nullptr) {
+        ErrorHandler::throw_runtime_error("couldn't map " + args[0].string_value, line);
+      }
+      Value val(Utils::STR);
+      // the string is a view, the mapping lives as long as the string or any slice of it
+      val.string_value = SharedString(file, file->view());
       return val;
     }
 };
@@ -390,7 +842,7 @@ class NativeFilewrite : public NativeFunction {
         val.boolean_value = false;
         return val;
       }
-      f << args[1].string_value;
+      f << args[1].string_value.view();
       f.close();
       val.boolean_value = true;
       return val;
@@ -422,6 +874,164 @@ class NativeFileremove : public NativeFunction {
     }
 };
 
+// the handle argument of the file_* natives, which has to be open
+static FileHandle &file_arg(const Value &handle, const std::string &fn, std::int64_t line, CVM &VM) {
+  FileHandle *file = VM.files.get(handle.number_value);
+  if (file == nullptr) {
+    ErrorHandler::throw_runtime_error(fn + "() " + std::to_string(handle.number_value) + " is not an open file handle", line);
+  }
+  return *file;
+}
+
+class NativeFileopen : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::STR || args[1].type != Utils::STR) {
+        ErrorHandler::throw_runtime_error("file_open() expects two arguments (str, str)", line);
+      }
+      std::string error;
+      std::unique_ptr<FileHandle> file = FileHandle::open(args[0].string_value, args[1].string_value.view(), error);
+      if (file == nullptr) {
+        ErrorHandler::throw_runtime_error("file_open() " + error, line);
+      }
+      Value val(Utils::INT);
+      val.number_value = VM.files.add(std::move(file));
+      return val;
+    }
+};
+
+class NativeFilewritechunk : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::INT || args[1].type != Utils::STR) {
+        ErrorHandler::throw_runtime_error("file_write_chunk() expects two arguments (int, str)", line);
+      }
+      FileHandle &file = file_arg(args[0], "file_write_chunk", line, VM);
+      if (!file.can_write()) {
+        ErrorHandler::throw_runtime_error("file_write_chunk() file wasn't opened for writing", line);
+      }
+      if (!file.write(args[1].string_value.view())) {
+        ErrorHandler::throw_runtime_error("file_write_chunk() couldn't write: " + std::string(std::strerror(errno)), line);
+      }
+      return {Utils::VOID};
+    }
+};
+
+class NativeFilereadchunk : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::INT || args[1].type != Utils::INT) {
+        ErrorHandler::throw_runtime_error("file_read_chunk() expects two arguments (int, int)", line);
+      }
+      if (args[1].number_value < 0) {
+        ErrorHandler::throw_runtime_error("file_read_chunk() size cannot be negative", line);
+      }
+      FileHandle &file = file_arg(args[0], "file_read_chunk", line, VM);
+      if (!file.can_read()) {
+        ErrorHandler::throw_runtime_error("file_read_chunk() file wasn't opened for reading", line);
+      }
+      Value val(Utils::STR);
+      if (!file.read(args[1].number_value, val.string_value.mut())) {
+        ErrorHandler::throw_runtime_error("file_read_chunk() couldn't read: " + std::string(std::strerror(errno)), line);
+      }
+      return val;
+    }
+};
+
+class NativeFileseek : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if ((args.size() != 2 && args.size() != 3) || args[0].type != Utils::INT || args[1].type != Utils::INT ||
+        (args.size() == 3 && args[2].type != Utils::STR)) {
+        ErrorHandler::throw_runtime_error("file_seek() expects two or three arguments (int, int[, str])", line);
+      }
+      int whence = SEEK_SET;
+      if (args.size() == 3) {
+        const std::string_view from = args[2].string_value.view();
+        if (from == "current") {
+          whence = SEEK_CUR;
+        } else if (from == "end") {
+          whence = SEEK_END;
+        } else if (from != "start") {
+          ErrorHandler::throw_runtime_error("file_seek() expects start, current or end, got " + args[2].string_value, line);
+        }
+      }
+      FileHandle &file = file_arg(args[0], "file_seek", line, VM);
+      Value val(Utils::INT);
+      val.number_value = file.seek(args[1].number_value, whence);
+      if (val.number_value == -1) {
+        ErrorHandler::throw_runtime_error("file_seek() couldn't seek: " + std::string(std::strerror(errno)), line);
+      }
+      return val;
+    }
+};
+
+class NativeFileclose : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::INT) {
+        ErrorHandler::throw_runtime_error("file_close() expects one argument (int)", line);
+      }
+      file_arg(args[0], "file_close", line, VM);
+      if (!VM.files.close(args[0].number_value)) {
+        ErrorHandler::throw_runtime_error("file_close() couldn't write: " + std::string(std::strerror(errno)), line);
+      }
+      return {Utils::VOID};
+    }
+};
+
+// schema is an array of "name:type" strings, one for every column, type is int, double or str
+class NativeCsvread : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::STR || args[1].type != Utils::ARR || args[1].array_type != "str") {
+        ErrorHandler::throw_runtime_error("csv_read() expects two arguments (str, arr of str)", line);
+      }
+      std::vector<CsvColumn> columns;
+      const std::size_t count = args[1].array_size();
+      for (std::size_t i = 0; i < count; i++) {
+        const std::string_view column = args[1].array_ref(i).string_value.view();
+        const std::size_t colon = column.rfind(':');
+        const std::string_view type = colon == std::string_view::npos ? "" : column.substr(colon + 1);
+        Utils::VarType column_type = type == "int" ? Utils::INT : type == "double" ? Utils::FLOAT : type == "str" ? Utils::STR : Utils::UNKNOWN;
+        if (colon == 0 || column_type == Utils::UNKNOWN) {
+          ErrorHandler::throw_runtime_error("csv_read() columns are described as name:int, name:double or name:str, got " + std::string(column), line);
+        }
+        const Symbol name = std::string(column.substr(0, colon));
+        for (const CsvColumn &other : columns) {
+          if (other.name == name) {
+            ErrorHandler::throw_runtime_error("csv_read() column " + name + " is described twice", line);
+          }
+        }
+        columns.emplace_back(name, column_type);
+      }
+      if (columns.empty()) {
+        ErrorHandler::throw_runtime_error("csv_read() expects at least one column", line);
+      }
+      std::shared_ptr<MappedFile> file = MappedFile::open(args[0].string_value);
+      if (file == nullptr) {
+        ErrorHandler::throw_runtime_error("couldn't read " + args[0].string_value, line);
+      }
+      std::string error;
+      if (!Csv::parse(file, columns, error)) {
+        ErrorHandler::throw_runtime_error("csv_read() " + args[0].string_value + " " + error, line);
+      }
+      Value res(Utils::OBJ);
+      res.class_name = "csv";
+      for (CsvColumn &column : columns) {
+        Value arr(Utils::ARR);
+        arr.set_array_type(type_name(column.type));
+        ArrayStorage &storage = arr.mut_array();
+        storage.ints = std::move(column.ints);
+        storage.floats = std::move(column.floats);
+        storage.values = std::move(column.strings);
+        arr.member_name = column.name;
+        res.member_values.emplace(column.name, std::move(arr));
+      }
+      return res;
+    }
+};
+
 class NativeAbs : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
@@ -451,13 +1061,11 @@ class NativeRand : public NativeFunction {
       if (args.size() != 2 || args[0].type != Utils::INT || args[1].type != Utils::INT) {
         ErrorHandler::throw_runtime_error("rand() expects two arguments (int, int)", line);
       }
+      if (args[0].number_value > args[1].number_value) {
+        ErrorHandler::throw_runtime_error("rand() lower bound cannot be greater than the upper bound", line);
+      }
       Value val(Utils::INT);
-      std::random_device rd;
-      std::default_random_engine generator(rd());
-      std::uniform_int_distribution<std::int64_t> distribution(
-        args[0].number_value, args[1].number_value
-      );
-      val.number_value = distribution(generator);
+      val.number_value = VM.random.between(args[0].number_value, args[1].number_value);
       return val;
     }
 };
@@ -469,139 +1077,1419 @@ class NativeRandf : public NativeFunction {
         ErrorHandler::throw_runtime_error("randf() expects two arguments (double, double)", line);
       }
       Value val(Utils::FLOAT);
-      std::random_device rd;
-      std::default_random_engine generator(rd());
-      std::uniform_real_distribution<double> distribution(
-        args[0].float_value, args[1].float_value
-      );
-      val.float_value = distribution(generator);
+      val.float_value = VM.random.between(args[0].float_value, args[1].float_value);
       return val;
     }
 };
 
-class NativeContains : public NativeFunction {
+class NativeSeed : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
-      if (args.size() != 2 || args[0].type != Utils::STR || args[1].type != Utils::STR) {
-        ErrorHandler::throw_runtime_error("contains() expects two arguments (str, str)", line);
+      if (args.size() != 1 || args[0].type != Utils::INT) {
+        ErrorHandler::throw_runtime_error("seed() expects one argument (int)", line);
       }
-      Value val(Utils::BOOL);
-      val.boolean_value = args[0].string_value.find(args[1].string_value) != std::string::npos;
-      return val;
+      VM.random.seed((std::uint64_t)args[0].number_value);
+      return {Utils::VOID};
     }
 };
 
-class NativeSubstr : public NativeFunction {
+// fills the packed storage directly, without a native call and a boxed value per element
+class NativeRandarray : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
-      if (args.size() != 3 || args[0].type != Utils::STR || args[1].type != Utils::INT || args[2].type != Utils::INT) {
-        ErrorHandler::throw_runtime_error("substr() expects three arguments (str, int, int)", line);
+      if (args.size() != 3 || args[0].type != Utils::INT || args[1].type != Utils::INT || args[2].type != Utils::INT) {
+        ErrorHandler::throw_runtime_error("rand_array() expects three arguments (int, int, int)", line);
       }
-      if (args[1].number_value < 0) {
-        ErrorHandler::throw_runtime_error("starting position cannot be negative", line);
+      if (args[0].number_value < 0) {
+        ErrorHandler::throw_runtime_error("Array size cannot be negative", line);
       }
-      if (args[2].number_value < 0) {
-        ErrorHandler::throw_runtime_error("length cannot be negative", line);
+      const std::int64_t lo = args[1].number_value, hi = args[2].number_value;
+      if (lo > hi) {
+        ErrorHandler::throw_runtime_error("rand_array() lower bound cannot be greater than the upper bound", line);
       }
-      if (args[1].number_value + args[2].number_value > args[0].string_value.size()) {
-        ErrorHandler::throw_runtime_error("out of string range", line);
+      Value res(Utils::ARR);
+      res.set_array_type("int");
+      std::vector<std::int64_t> &ints = res.mut_array().ints;
+      ints.resize(args[0].number_value);
+      for (std::int64_t &x : ints) {
+        x = VM.random.between(lo, hi);
       }
-      Value val(Utils::STR);
-      val.string_value = args[0].string_value.substr(args[1].number_value, args[2].number_value);
-      return val;
+      return res;
     }
 };
 
-class NativeSplit : public NativeFunction {
+class NativeRandfarray : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
-      if (args.size() != 2 || args[0].type != Utils::STR || args[1].type != Utils::STR) {
-        ErrorHandler::throw_runtime_error("split() expects two arguments (str, str)", line);
+      if (args.size() != 3 || args[0].type != Utils::INT || args[1].type != Utils::FLOAT || args[2].type != Utils::FLOAT) {
+        ErrorHandler::throw_runtime_error("randf_array() expects three arguments (int, double, double)", line);
+      }
+      if (args[0].number_value < 0) {
+        ErrorHandler::throw_runtime_error("Array size cannot be negative", line);
       }
+      const double lo = args[1].float_value, hi = args[2].float_value;
       Value res(Utils::ARR);
-      res.array_type = "str";
-      std::string delim_copy = args[1].string_value;
-      char *c_str = strdup(args[0].string_value.c_str());
-      const char *c_delim = delim_copy.c_str();
-      char *token = std::strtok(c_str, c_delim);
-      while (token != NULL) {
-        Value element;
-        element.type = Utils::STR;
-        element.string_value = token;
-        res.array_values.push_back(element);
-        token = std::strtok(NULL, c_delim);
+      res.set_array_type("double");
+      std::vector<double> &floats = res.mut_array().floats;
+      floats.resize(args[0].number_value);
+      for (double &x : floats) {
+        x = VM.random.between(lo, hi);
       }
-      std::free(c_str);
       return res;
     }
 };
 
-class NativeReplace : public NativeFunction {
+class NativeContains : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
-      if (args.size() != 3 || args[0].type != Utils::STR || args[1].type != Utils::STR || args[2].type != Utils::STR) {
-        ErrorHandler::throw_runtime_error("replace() expects three arguments (str, str, str)", line);
+      if (args.size() != 2 || args[0].type != Utils::STR || args[1].type != Utils::STR) {
+        ErrorHandler::throw_runtime_error("contains() expects two arguments (str, str)", line);
+      }
+      Value val(Utils::BOOL);
+      val.boolean_value = args[0].string_value.find(args[1].string_value.view()) != std::string::npos;
+      return val;
+    }
+};
+
+class NativeSubstr : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 3 || args[0].type != Utils::STR || args[1].type != Utils::INT || args[2].type != Utils::INT) {
+        ErrorHandler::throw_runtime_error("substr() expects three arguments (str, int, int)", line);
+      }
+      if (args[1].number_value < 0) {
+        ErrorHandler::throw_runtime_error("starting position cannot be negative", line);
+      }
+      if (args[2].number_value < 0) {
+        ErrorHandler::throw_runtime_error("length cannot be negative", line);
+      }
+      if (args[1].number_value + args[2].number_value > args[0].string_value.size()) {
+        ErrorHandler::throw_runtime_error("out of string range", line);
+      }
+      Value val(Utils::STR);
+      val.string_value = SharedString(args[0].string_value, args[1].number_value, args[2].number_value);
+      return val;
+    }
+};
+
+class NativeSlice : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 3 || (args[0].type != Utils::STR && args[0].type != Utils::ARR) || args[1].type != Utils::INT || args[2].type != Utils::INT) {
+        ErrorHandler::throw_runtime_error("slice() expects three arguments (str|arr, int, int)", line);
+      }
+      const std::int64_t from = args[1].number_value;
+      const std::int64_t to = args[2].number_value;
+      const std::size_t size = args[0].type == Utils::STR ? args[0].string_value.size() : args[0].array_size();
+      if (from < 0 || to < from || (std::size_t)to > size) {
+        ErrorHandler::throw_runtime_error("slice() range out of bounds", line);
+      }
+      // both share the storage of arg1 instead of copying the elements
+      if (args[0].type == Utils::STR) {
+        Value res(Utils::STR);
+        res.string_value = SharedString(args[0].string_value, from, to - from);
+        return res;
+      }
+      return args[0].slice(from, to - from);
+    }
+};
+
+class NativeSplit : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::STR || args[1].type != Utils::STR) {
+        ErrorHandler::throw_runtime_error("split() expects two arguments (str, str)", line);
+      }
+      Value res(Utils::ARR);
+      res.set_array_type("str");
+      ArrayStorage &storage = res.mut_array();
+      // tokens are views into the original string
+      const std::string_view str = args[0].string_value.view();
+      const std::string_view delims = args[1].string_value.view();
+      std::size_t start = str.find_first_not_of(delims);
+      while (start != std::string_view::npos) {
+        std::size_t end = str.find_first_of(delims, start);
+        if (end == std::string_view::npos) end = str.size();
+        Value element(Utils::STR);
+        element.string_value = SharedString(args[0].string_value, start, end - start);
+        storage.values.push_back(std::move(element));
+        start = str.find_first_not_of(delims, end);
+      }
+      return res;
+    }
+};
+
+class NativeReplace : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 3 || args[0].type != Utils::STR || args[1].type != Utils::STR || args[2].type != Utils::STR) {
+        ErrorHandler::throw_runtime_error("replace() expects three arguments (str, str, str)", line);
+      }
+      const std::size_t index = args[0].string_value.find(args[1].string_value.view());
+      if (index == std::string::npos) {
+        return args[0];
+      }
+      Value res(Utils::STR);
+      const std::size_t str_len = args[1].string_value.length();
+      res.string_value = args[0].string_value.mut().replace(index, str_len, args[2].string_value);
+      return res;
+    }
+};
+
+class NativeReplaceall : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 3 || args[0].type != Utils::STR || args[1].type != Utils::STR || args[2].type != Utils::STR) {
+        ErrorHandler::throw_runtime_error("replace_all() expects three arguments (str, str, str)", line);
+      }
+      Value res(Utils::STR);
+      const std::string_view pattern = args[1].string_value.view();
+      const std::string_view replacement = args[2].string_value.view();
+      // patterns without metacharacters are plain substrings, unless the replacement refers to the match with $
+      if (!pattern.empty() && pattern.find_first_of("^$\\.*+?()[]{}|") == std::string_view::npos && replacement.find('$') == std::string_view::npos) {
+        const std::string_view str = args[0].string_value.view();
+        std::size_t index = str.find(pattern);
+        if (index == std::string_view::npos) {
+          return args[0];
+        }
+        std::string &out = res.string_value.mut();
+        out.reserve(str.size());
+        std::size_t from = 0;
+        for (; index != std::string_view::npos; index = str.find(pattern, from)) {
+          out.append(str.data() + from, index - from);
+          out.append(replacement);
+          from = index + pattern.size();
+        }
+        out.append(str.data() + from, str.size() - from);
+        return res;
+      }
+      try {
+        res.string_value = std::regex_replace(args[0].string_value.str(), VM.regexes.get(args[1].string_value.str()), args[2].string_value.str());
+      } catch (const std::regex_error &e) {
+        ErrorHandler::throw_runtime_error("replace_all() got an invalid regular expression " + args[1].string_value, line);
+      }
+      return res;
+    }
+};
+
+class NativeTobytes : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::STR) {
+        ErrorHandler::throw_runtime_error("to_bytes() expects one argument (str)", line);
+      }
+      Value res(Utils::ARR);
+      res.set_array_type("int");
+      std::vector<std::int64_t> &bytes = res.mut_array().ints;
+      const std::string_view str = args[0].string_value.view();
+      bytes.reserve(str.size());
+      for (const char c : str) {
+        if (c == '\0') break;
+        bytes.push_back((std::int64_t)c);
+      }
+      return res;
+    }
+};
+
+class NativeFrombytes : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::ARR) {
+        ErrorHandler::throw_runtime_error("from_bytes() expects one argument (arr)", line);
+      }
+      if (args[0].array_type != "int") {
+        ErrorHandler::throw_runtime_error("from_bytes() expects an int array", line);
+      }
+      Value res(Utils::STR);
+      std::string &str = res.string_value.mut();
+      const std::size_t size = args[0].array_size();
+      str.reserve(size);
+      if (args[0].is_packed()) {
+        const std::int64_t *bytes = args[0].ints();
+        for (std::size_t i = 0; i < size; i++) {
+          str += (char)bytes[i];
+        }
+        return res;
+      }
+      for (std::size_t i = 0; i < size; i++) {
+        str += (char)args[0].array_ref(i).number_value;
+      }
+      return res;
+    }
+};
+
+class NativeBuildernew : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() > 1 || (args.size() == 1 && args[0].type != Utils::INT)) {
+        ErrorHandler::throw_runtime_error("builder_new() expects zero or one argument (int)", line);
+      }
+      Value res(Utils::BUILDER);
+      res.handle = std::make_shared<std::string>();
+      if (args.size() == 1 && args[0].number_value > 0) {
+        res.builder().reserve(args[0].number_value);
+      }
+      return res;
+    }
+};
+
+class NativeBuilderappend : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() < 2 || args[0].type != Utils::BUILDER) {
+        ErrorHandler::throw_runtime_error("builder_append() expects at least two arguments (builder, ...)", line);
+      }
+      std::string &buffer = args[0].builder();
+      // numbers are formatted straight into the buffer, std::string grows it geometrically
+      for (std::size_t i = 1; i < args.size(); i++) {
+        VM.stringify(args[i], buffer);
+      }
+      return {Utils::VOID};
+    }
+};
+
+class NativeBuilderstr : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::BUILDER) {
+        ErrorHandler::throw_runtime_error("builder_str() expects one argument (builder)", line);
+      }
+      Value res(Utils::STR);
+      res.string_value = args[0].builder();
+      return res;
+    }
+};
+
+class NativeMapnew : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() > 1 || (args.size() == 1 && args[0].type != Utils::INT)) {
+        ErrorHandler::throw_runtime_error("map_new() expects zero or one argument (int)", line);
+      }
+      Value res(Utils::MAP);
+      res.handle = std::make_shared<HashMap>();
+      if (args.size() == 1 && args[0].number_value > 0) {
+        res.hash_map().reserve(args[0].number_value);
+      }
+      return res;
+    }
+};
+
+// the first insertion decides the key and value types of a map
+static void check_map_types(const HashMap &map, const Value &key, const Value *value, const std::string &fn, std::int64_t line) {
+  if (!HashKey::hashable(key)) {
+    ErrorHandler::throw_runtime_error(fn + "() key has to be an int, double, str or bool", line);
+  }
+  if (map.key_type != Utils::UNKNOWN && key.type != map.key_type) {
+    ErrorHandler::throw_runtime_error(fn + "() map has keys of type " + type_name(map.key_type) + ", got " + type_name(key.type), line);
+  }
+  if (value != nullptr && map.value_type != Utils::UNKNOWN && value->type != map.value_type) {
+    ErrorHandler::throw_runtime_error(fn + "() map has values of type " + type_name(map.value_type) + ", got " + type_name(value->type), line);
+  }
+}
+
+class NativeMapset : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 3 || args[0].type != Utils::MAP) {
+        ErrorHandler::throw_runtime_error("map_set() expects three arguments (map, key, value)", line);
+      }
+      HashMap &map = args[0].hash_map();
+      check_map_types(map, args[1], &args[2], "map_set", line);
+      map.key_type = args[1].type;
+      map.value_type = args[2].type;
+      bool inserted;
+      map.insert(HashKey(args[1]), inserted).value = std::move(args[2]);
+      return {Utils::VOID};
+    }
+};
+
+class NativeMapget : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() < 2 || args.size() > 3 || args[0].type != Utils::MAP) {
+        ErrorHandler::throw_runtime_error("map_get() expects two or three arguments (map, key, [default])", line);
+      }
+      HashMap &map = args[0].hash_map();
+      check_map_types(map, args[1], nullptr, "map_get", line);
+      MapEntry *entry = map.find(HashKey(args[1]));
+      if (entry != nullptr) {
+        return entry->value;
+      }
+      if (args.size() == 3) {
+        return args[2];
+      }
+      ErrorHandler::throw_runtime_error("map_get() key " + VM.stringify(args[1]) + " not found", line);
+      return {Utils::VOID};
+    }
+};
+
+class NativeMaphas : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::MAP) {
+        ErrorHandler::throw_runtime_error("map_has() expects two arguments (map, key)", line);
+      }
+      HashMap &map = args[0].hash_map();
+      check_map_types(map, args[1], nullptr, "map_has", line);
+      Value res(Utils::BOOL);
+      res.boolean_value = map.find(HashKey(args[1])) != nullptr;
+      return res;
+    }
+};
+
+class NativeMapremove : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::MAP) {
+        ErrorHandler::throw_runtime_error("map_remove() expects two arguments (map, key)", line);
+      }
+      HashMap &map = args[0].hash_map();
+      check_map_types(map, args[1], nullptr, "map_remove", line);
+      Value res(Utils::BOOL);
+      res.boolean_value = map.erase(HashKey(args[1]));
+      return res;
+    }
+};
+
+class NativeMapkeys : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::MAP) {
+        ErrorHandler::throw_runtime_error("map_keys() expects one argument (map)", line);
+      }
+      const HashMap &map = args[0].hash_map();
+      Value res(Utils::ARR);
+      res.set_array_type(map.key_type == Utils::UNKNOWN ? "int" : type_name(map.key_type));
+      for (const auto &entry : map.entries) {
+        res.array_push(entry.key.to_value());
+      }
+      return res;
+    }
+};
+
+class NativeMapvalues : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::MAP) {
+        ErrorHandler::throw_runtime_error("map_values() expects one argument (map)", line);
+      }
+      const HashMap &map = args[0].hash_map();
+      Value res(Utils::ARR);
+      res.set_array_type(map.value_type == Utils::UNKNOWN ? "int" : type_name(map.value_type));
+      for (const auto &entry : map.entries) {
+        res.array_push(entry.value);
+      }
+      return res;
+    }
+};
+
+// the first insertion decides the element type of a set
+static void check_set_type(const HashSet &set, const Value &element, const std::string &fn, std::int64_t line) {
+  if (!HashKey::hashable(element)) {
+    ErrorHandler::throw_runtime_error(fn + "() element has to be an int, double, str or bool", line);
+  }
+  if (set.element_type != Utils::UNKNOWN && element.type != set.element_type) {
+    ErrorHandler::throw_runtime_error(fn + "() set has elements of type " + type_name(set.element_type) + ", got " + type_name(element.type), line);
+  }
+}
+
+static Value new_set(Utils::VarType element_type) {
+  Value res(Utils::SET);
+  res.handle = std::make_shared<HashSet>();
+  res.hash_set().element_type = element_type;
+  return res;
+}
+
+class NativeSetnew : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() > 1 || (args.size() == 1 && args[0].type != Utils::INT && args[0].type != Utils::ARR)) {
+        ErrorHandler::throw_runtime_error("set_new() expects zero or one argument (int|arr)", line);
+      }
+      Value res = new_set(Utils::UNKNOWN);
+      HashSet &set = res.hash_set();
+      if (args.size() == 1 && args[0].type == Utils::INT && args[0].number_value > 0) {
+        set.reserve(args[0].number_value);
+      } else if (args.size() == 1 && args[0].type == Utils::ARR) {
+        const Value &elements = args[0];
+        const std::size_t size = elements.array_size();
+        set.reserve(size);
+        for (std::size_t i = 0; i < size; i++) {
+          const Value element = elements.array_at(i);
+          check_set_type(set, element, "set_new", line);
+          set.element_type = element.type;
+          bool inserted;
+          set.insert(HashKey(element), inserted);
+        }
+      }
+      return res;
+    }
+};
+
+class NativeSetadd : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::SET) {
+        ErrorHandler::throw_runtime_error("set_add() expects two arguments (hashset, any)", line);
+      }
+      HashSet &set = args[0].hash_set();
+      check_set_type(set, args[1], "set_add", line);
+      set.element_type = args[1].type;
+      Value res(Utils::BOOL);
+      set.insert(HashKey(args[1]), res.boolean_value);
+      return res;
+    }
+};
+
+class NativeSetremove : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::SET) {
+        ErrorHandler::throw_runtime_error("set_remove() expects two arguments (hashset, any)", line);
+      }
+      HashSet &set = args[0].hash_set();
+      check_set_type(set, args[1], "set_remove", line);
+      Value res(Utils::BOOL);
+      res.boolean_value = set.erase(HashKey(args[1]));
+      return res;
+    }
+};
+
+class NativeSethas : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::SET) {
+        ErrorHandler::throw_runtime_error("set_has() expects two arguments (hashset, any)", line);
+      }
+      HashSet &set = args[0].hash_set();
+      check_set_type(set, args[1], "set_has", line);
+      Value res(Utils::BOOL);
+      res.boolean_value = set.find(HashKey(args[1])) != nullptr;
+      return res;
+    }
+};
+
+// both sets have to hold the same type of elements, unless one of them is still empty
+static Utils::VarType common_element_type(std::vector<Value> &args, const std::string &fn, std::int64_t line) {
+  if (args.size() != 2 || args[0].type != Utils::SET || args[1].type != Utils::SET) {
+    ErrorHandler::throw_runtime_error(fn + "() expects two arguments (hashset, hashset)", line);
+  }
+  const Utils::VarType a = args[0].hash_set().element_type;
+  const Utils::VarType b = args[1].hash_set().element_type;
+  if (a != Utils::UNKNOWN && b != Utils::UNKNOWN && a != b) {
+    ErrorHandler::throw_runtime_error(fn + "() can't combine a set of " + type_name(a) + " with a set of " + type_name(b), line);
+  }
+  return a != Utils::UNKNOWN ? a : b;
+}
+
+class NativeSetunion : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      Value res = new_set(common_element_type(args, "set_union", line));
+      HashSet &set = res.hash_set();
+      const HashSet &a = args[0].hash_set();
+      const HashSet &b = args[1].hash_set();
+      set.reserve(a.size() + b.size());
+      bool inserted;
+      for (const auto &entry : a.entries) set.insert(entry.key, inserted);
+      for (const auto &entry : b.entries) set.insert(entry.key, inserted);
+      return res;
+    }
+};
+
+class NativeSetintersection : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      Value res = new_set(common_element_type(args, "set_intersection", line));
+      HashSet &set = res.hash_set();
+      HashSet &a = args[0].hash_set();
+      HashSet &b = args[1].hash_set();
+      // probe the bigger set with the elements of the smaller one
+      HashSet &smaller = a.size() <= b.size() ? a : b;
+      HashSet &bigger = a.size() <= b.size() ? b : a;
+      bool inserted;
+      for (const auto &entry : smaller.entries) {
+        if (bigger.find(entry.key) != nullptr) set.insert(entry.key, inserted);
+      }
+      return res;
+    }
+};
+
+class NativeSetdifference : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      Value res = new_set(common_element_type(args, "set_difference", line));
+      HashSet &set = res.hash_set();
+      HashSet &b = args[1].hash_set();
+      bool inserted;
+      for (const auto &entry : args[0].hash_set().entries) {
+        if (b.find(entry.key) == nullptr) set.insert(entry.key, inserted);
+      }
+      return res;
+    }
+};
+
+class NativeSetvalues : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::SET) {
+        ErrorHandler::throw_runtime_error("set_values() expects one argument (hashset)", line);
+      }
+      const HashSet &set = args[0].hash_set();
+      Value res(Utils::ARR);
+      res.set_array_type(set.element_type == Utils::UNKNOWN ? "int" : type_name(set.element_type));
+      for (const auto &entry : set.entries) {
+        res.array_push(entry.key.to_value());
+      }
+      return res;
+    }
+};
+
+// keys of ordered maps have to be comparable, doubles can't be nan
+static void check_omap_types(const OrderedMap &map, const Value &key, const Value *value, const std::string &fn, std::int64_t line) {
+  if (key.heap_reference != -1 || (key.type != Utils::INT && key.type != Utils::FLOAT && key.type != Utils::STR)) {
+    ErrorHandler::throw_runtime_error(fn + "() key has to be an int, double or str", line);
+  }
+  if (key.type == Utils::FLOAT && std::isnan(key.float_value)) {
+    ErrorHandler::throw_runtime_error(fn + "() key can't be nan", line);
+  }
+  if (map.key_type != Utils::UNKNOWN && key.type != map.key_type) {
+    ErrorHandler::throw_runtime_error(fn + "() map has keys of type " + type_name(map.key_type) + ", got " + type_name(key.type), line);
+  }
+  if (value != nullptr && map.value_type != Utils::UNKNOWN && value->type != map.value_type) {
+    ErrorHandler::throw_runtime_error(fn + "() map has values of type " + type_name(map.value_type) + ", got " + type_name(value->type), line);
+  }
+}
+
+class NativeOmapnew : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 0) {
+        ErrorHandler::throw_runtime_error("omap_new() expects no arguments", line);
+      }
+      Value res(Utils::OMAP);
+      res.handle = std::make_shared<OrderedMap>();
+      return res;
+    }
+};
+
+class NativeOmapset : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 3 || args[0].type != Utils::OMAP) {
+        ErrorHandler::throw_runtime_error("omap_set() expects three arguments (omap, key, value)", line);
+      }
+      OrderedMap &map = args[0].ordered_map();
+      check_omap_types(map, args[1], &args[2], "omap_set", line);
+      map.key_type = args[1].type;
+      map.value_type = args[2].type;
+      map.set(HashKey(args[1], false), args[2]);
+      return {Utils::VOID};
+    }
+};
+
+class NativeOmapget : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() < 2 || args.size() > 3 || args[0].type != Utils::OMAP) {
+        ErrorHandler::throw_runtime_error("omap_get() expects two or three arguments (omap, key, [default])", line);
+      }
+      const OrderedMap &map = args[0].ordered_map();
+      check_omap_types(map, args[1], nullptr, "omap_get", line);
+      const Value *value = map.find(HashKey(args[1], false));
+      if (value != nullptr) {
+        return *value;
+      }
+      if (args.size() == 3) {
+        return args[2];
+      }
+      ErrorHandler::throw_runtime_error("omap_get() key " + VM.stringify(args[1]) + " not found", line);
+      return {Utils::VOID};
+    }
+};
+
+class NativeOmaphas : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::OMAP) {
+        ErrorHandler::throw_runtime_error("omap_has() expects two arguments (omap, key)", line);
+      }
+      const OrderedMap &map = args[0].ordered_map();
+      check_omap_types(map, args[1], nullptr, "omap_has", line);
+      Value res(Utils::BOOL);
+      res.boolean_value = map.find(HashKey(args[1], false)) != nullptr;
+      return res;
+    }
+};
+
+class NativeOmapremove : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::OMAP) {
+        ErrorHandler::throw_runtime_error("omap_remove() expects two arguments (omap, key)", line);
+      }
+      OrderedMap &map = args[0].ordered_map();
+      check_omap_types(map, args[1], nullptr, "omap_remove", line);
+      Value res(Utils::BOOL);
+      res.boolean_value = map.erase(HashKey(args[1], false));
+      return res;
+    }
+};
+
+// floor and ceil return the key they found, or the default if there is none
+static Value omap_bound(std::vector<Value> &args, bool floor, std::int64_t line, CVM &VM) {
+  const std::string fn = floor ? "omap_floor" : "omap_ceil";
+  if (args.size() < 2 || args.size() > 3 || args[0].type != Utils::OMAP) {
+    ErrorHandler::throw_runtime_error(fn + "() expects two or three arguments (omap, key, [default])", line);
+  }
+  const OrderedMap &map = args[0].ordered_map();
+  check_omap_types(map, args[1], nullptr, fn, line);
+  const HashKey key(args[1], false);
+  const OrderedMap::Position pos = floor ? map.floor(key) : map.lower_bound(key);
+  if (pos.valid()) {
+    return pos.key().to_value();
+  }
+  if (args.size() == 3) {
+    return args[2];
+  }
+  ErrorHandler::throw_runtime_error(fn + "() no key " + (floor ? "<= " : ">= ") + VM.stringify(args[1]), line);
+  return {Utils::VOID};
+}
+
+class NativeOmapfloor : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      return omap_bound(args, true, line, VM);
+    }
+};
+
+class NativeOmapceil : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      return omap_bound(args, false, line, VM);
+    }
+};
+
+// keys or values of the entries from key args[1] up to (excluding) key args[2], or of all entries
+static Value omap_scan(std::vector<Value> &args, bool keys, const std::string &fn, std::int64_t line) {
+  const bool range = args.size() == 3;
+  if (args.empty() || args[0].type != Utils::OMAP || args.size() != (range ? 3 : 1)) {
+    ErrorHandler::throw_runtime_error(fn + (range ? "() expects three arguments (omap, key, key)" : "() expects one argument (omap)"), line);
+  }
+  const OrderedMap &map = args[0].ordered_map();
+  Utils::VarType type = keys ? map.key_type : map.value_type;
+  Value res(Utils::ARR);
+  res.set_array_type(type == Utils::UNKNOWN ? "int" : type_name(type));
+  OrderedMap::Position pos = map.begin();
+  HashKey to;
+  if (range) {
+    check_omap_types(map, args[1], nullptr, fn, line);
+    check_omap_types(map, args[2], nullptr, fn, line);
+    pos = map.lower_bound(HashKey(args[1], false));
+    to = HashKey(args[2], false);
+  }
+  for (; pos.valid() && (!range || key_less(pos.key(), to)); pos.next()) {
+    if (keys) {
+      res.array_push(pos.key().to_value());
+    } else {
+      res.array_push(pos.value());
+    }
+  }
+  return res;
+}
+
+class NativeOmaprange : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 3) {
+        ErrorHandler::throw_runtime_error("omap_range() expects three arguments (omap, key, key)", line);
+      }
+      return omap_scan(args, true, "omap_range", line);
+    }
+};
+
+class NativeOmaprangevalues : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 3) {
+        ErrorHandler::throw_runtime_error("omap_range_values() expects three arguments (omap, key, key)", line);
+      }
+      return omap_scan(args, false, "omap_range_values", line);
+    }
+};
+
+class NativeOmapkeys : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1) {
+        ErrorHandler::throw_runtime_error("omap_keys() expects one argument (omap)", line);
+      }
+      return omap_scan(args, true, "omap_keys", line);
+    }
+};
+
+class NativeOmapvalues : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1) {
+        ErrorHandler::throw_runtime_error("omap_values() expects one argument (omap)", line);
+      }
+      return omap_scan(args, false, "omap_values", line);
+    }
+};
+
+// the first insertion decides the element type of a deque or priority queue
+static void check_element_type(Utils::VarType &element_type, const Value &val, const std::string &fn, std::int64_t line) {
+  if (element_type != Utils::UNKNOWN && val.type != element_type) {
+    ErrorHandler::throw_runtime_error(fn + "() expects elements of type " + type_name(element_type) + ", got " + type_name(val.type), line);
+  }
+  element_type = val.type;
+}
+
+class NativeDequenew : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 0) {
+        ErrorHandler::throw_runtime_error("deque_new() expects no arguments", line);
+      }
+      Value res(Utils::DEQUE);
+      res.handle = std::make_shared<Deque>();
+      return res;
+    }
+};
+
+class NativeDequepushback : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::DEQUE) {
+        ErrorHandler::throw_runtime_error("deque_push_back() expects two arguments (deque, any)", line);
+      }
+      Deque &deque = args[0].deque();
+      check_element_type(deque.element_type, args[1], "deque_push_back", line);
+      deque.push_back(args[1]);
+      return {Utils::VOID};
+    }
+};
+
+class NativeDequepushfront : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::DEQUE) {
+        ErrorHandler::throw_runtime_error("deque_push_front() expects two arguments (deque, any)", line);
+      }
+      Deque &deque = args[0].deque();
+      check_element_type(deque.element_type, args[1], "deque_push_front", line);
+      deque.push_front(args[1]);
+      return {Utils::VOID};
+    }
+};
+
+// the deque argument of the pop, front and back natives, which can't be empty
+static Deque &non_empty_deque(std::vector<Value> &args, const std::string &fn, std::int64_t line) {
+  if (args.size() != 1 || args[0].type != Utils::DEQUE) {
+    ErrorHandler::throw_runtime_error(fn + "() expects one argument (deque)", line);
+  }
+  Deque &deque = args[0].deque();
+  if (deque.size() == 0) {
+    ErrorHandler::throw_runtime_error(fn + "() called on an empty deque", line);
+  }
+  return deque;
+}
+
+class NativeDequepopback : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      return non_empty_deque(args, "deque_pop_back", line).pop_back();
+    }
+};
+
+class NativeDequepopfront : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      return non_empty_deque(args, "deque_pop_front", line).pop_front();
+    }
+};
+
+class NativeDequefront : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      return non_empty_deque(args, "deque_front", line).at(0);
+    }
+};
+
+class NativeDequeback : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      const Deque &deque = non_empty_deque(args, "deque_back", line);
+      return deque.at(deque.size() - 1);
+    }
+};
+
+class NativeDequeget : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::DEQUE || args[1].type != Utils::INT) {
+        ErrorHandler::throw_runtime_error("deque_get() expects two arguments (deque, int)", line);
+      }
+      const Deque &deque = args[0].deque();
+      if (args[1].number_value < 0 || (std::size_t)args[1].number_value >= deque.size()) {
+        ErrorHandler::throw_runtime_error("deque_get() index " + std::to_string(args[1].number_value) + " out of range", line);
+      }
+      return deque.at(args[1].number_value);
+    }
+};
+
+class NativeDequevalues : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::DEQUE) {
+        ErrorHandler::throw_runtime_error("deque_values() expects one argument (deque)", line);
+      }
+      const Deque &deque = args[0].deque();
+      Value res(Utils::ARR);
+      res.set_array_type(deque.element_type == Utils::UNKNOWN ? "int" : type_name(deque.element_type));
+      for (std::size_t i = 0; i < deque.size(); i++) {
+        res.array_push(deque.at(i));
+      }
+      return res;
+    }
+};
+
+// orders the elements of a priority queue, smallest first or by its comparator
+class QueueOrder {
+  private:
+    std::unique_ptr<FunctionCaller> comparator;
+    std::int64_t line;
+  public:
+    QueueOrder(const PriorityQueue &queue, std::int64_t _line, CVM &VM) : line(_line) {
+      if (queue.comparator.type == Utils::FUNC) {
+        comparator = std::make_unique<FunctionCaller>(*VM.evaluator, queue.comparator);
+      }
+    }
+    bool operator()(const Value &a, const Value &b) {
+      if (comparator != nullptr) {
+        const Value *args[] = {&a, &b};
+        const Value res = comparator->call(args);
+        if (res.type != Utils::BOOL) {
+          ErrorHandler::throw_runtime_error("pqueue comparator has to return a bool", line);
+        }
+        return res.boolean_value;
+      }
+      if (a.type == Utils::INT) return a.number_value < b.number_value;
+      if (a.type == Utils::FLOAT) return a.float_value < b.float_value;
+      if (a.type == Utils::STR) return a.string_value.view() < b.string_value.view();
+      return a.boolean_value < b.boolean_value;
+    }
+};
+
+class NativePqueuenew : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() > 1 || (args.size() == 1 && args[0].type != Utils::FUNC)) {
+        ErrorHandler::throw_runtime_error("pqueue_new() expects zero or one argument (func)", line);
+      }
+      Value res(Utils::PQUEUE);
+      res.handle = std::make_shared<PriorityQueue>();
+      if (args.size() == 1) {
+        if (args[0].func.params.size() != 2) {
+          ErrorHandler::throw_runtime_error("pqueue_new() expects a function with 2 parameters", line);
+        }
+        res.priority_queue().comparator = args[0];
+      }
+      return res;
+    }
+};
+
+class NativePqueuepush : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::PQUEUE) {
+        ErrorHandler::throw_runtime_error("pqueue_push() expects two arguments (pqueue, any)", line);
       }
-      const std::size_t index = args[0].string_value.find(args[1].string_value);
-      if (index == std::string::npos) {
-        return args[0];
+      PriorityQueue &queue = args[0].priority_queue();
+      const Value &val = args[1];
+      if (queue.comparator.type != Utils::FUNC && (val.heap_reference != -1 || (val.type != Utils::INT && val.type != Utils::FLOAT && val.type != Utils::STR && val.type != Utils::BOOL))) {
+        ErrorHandler::throw_runtime_error("pqueue_push() without a comparator the elements have to be ints, doubles, strings or bools", line);
+      }
+      check_element_type(queue.element_type, val, "pqueue_push", line);
+      queue.push(val, QueueOrder(queue, line, VM));
+      return {Utils::VOID};
+    }
+};
+
+class NativePqueuepop : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::PQUEUE) {
+        ErrorHandler::throw_runtime_error("pqueue_pop() expects one argument (pqueue)", line);
+      }
+      PriorityQueue &queue = args[0].priority_queue();
+      if (queue.size() == 0) {
+        ErrorHandler::throw_runtime_error("pqueue_pop() called on an empty pqueue", line);
+      }
+      return queue.pop(QueueOrder(queue, line, VM));
+    }
+};
+
+class NativePqueuepeek : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::PQUEUE) {
+        ErrorHandler::throw_runtime_error("pqueue_peek() expects one argument (pqueue)", line);
+      }
+      const PriorityQueue &queue = args[0].priority_queue();
+      if (queue.size() == 0) {
+        ErrorHandler::throw_runtime_error("pqueue_peek() called on an empty pqueue", line);
+      }
+      return queue.heap.front();
+    }
+};
+
+class NativeSort : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() < 1 || args.size() > 2 || args[0].type != Utils::ARR || (args.size() == 2 && args[1].type != Utils::FUNC)) {
+        ErrorHandler::throw_runtime_error("sort() expects one or two arguments (arr, [func])", line);
+      }
+      Value &arr = args[0];
+      const std::size_t size = arr.array_size();
+      if (args.size() == 2) {
+        // the comparator runs in the evaluator, so this sort stays on one thread
+        // stable_sort never reads outside of the array, even if the comparator isn't consistent
+        FunctionCaller comparator(*VM.evaluator, args[1]);
+        if (comparator.arity() != 2) {
+          ErrorHandler::throw_runtime_error("sort() expects a function with 2 parameters", line);
+        }
+        std::vector<Value> elements;
+        elements.reserve(size);
+        for (std::size_t i = 0; i < size; i++) {
+          elements.push_back(arr.array_at(i));
+        }
+        std::stable_sort(elements.begin(), elements.end(), [&](const Value &a, const Value &b) {
+          const Value *cmp_args[] = {&a, &b};
+          const Value res = comparator.call(cmp_args);
+          if (res.type != Utils::BOOL) {
+            ErrorHandler::throw_runtime_error("sort() comparator has to return a bool", line);
+          }
+          return res.boolean_value;
+        });
+        for (std::size_t i = 0; i < size; i++) {
+          arr.array_set(i, elements[i]);
+        }
+        return arr;
+      }
+      if (arr.packed_type == Utils::INT) {
+        Sort::ints(arr.mut_ints(), size);
+      } else if (arr.packed_type == Utils::FLOAT) {
+        Sort::floats(arr.mut_floats(), size);
+      } else if (arr.packed_type == Utils::BOOL) {
+        // falses first
+        std::vector<bool> &bools = arr.mut_array().bools;
+        const std::size_t trues = std::count(bools.begin(), bools.end(), true);
+        std::fill(bools.begin(), bools.end() - trues, false);
+        std::fill(bools.end() - trues, bools.end(), true);
+      } else if (arr.array_type == "str") {
+        std::vector<Value> &values = arr.mut_array().values;
+        for (const auto &val : values) {
+          if (val.type != Utils::STR || val.heap_reference != -1) {
+            ErrorHandler::throw_runtime_error("sort() without a comparator can't sort references", line);
+          }
+        }
+        Sort::strings(values);
+      } else {
+        ErrorHandler::throw_runtime_error("sort() needs a comparator to sort an array of " + arr.array_type, line);
+      }
+      return arr;
+    }
+};
+
+// the array and function arguments of transform(), filter(), reduce() and for_each()
+static FunctionCaller array_callback(std::vector<Value> &args, std::size_t count, std::size_t arity, const std::string &fn, const std::string &signature, std::int64_t line, CVM &VM) {
+  if (args.size() != count || args[0].type != Utils::ARR || args[1].type != Utils::FUNC) {
+    ErrorHandler::throw_runtime_error(fn + "() expects " + std::to_string(count) + " arguments " + signature, line);
+  }
+  FunctionCaller caller(*VM.evaluator, args[1]);
+  if (caller.arity() != arity) {
+    ErrorHandler::throw_runtime_error(fn + "() expects a function with " + std::to_string(arity) + (arity == 1 ? " parameter" : " parameters"), line);
+  }
+  return caller;
+}
+
+class NativeTransform : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      FunctionCaller caller = array_callback(args, 2, 1, "transform", "(arr, func)", line, VM);
+      const Value &arr = args[0];
+      const std::size_t size = arr.array_size();
+      Value res(Utils::ARR);
+      if (args[1].func.ret_type == "void") {
+        ErrorHandler::throw_runtime_error("transform() expects a function that returns a value", line);
+      }
+      res.set_array_type(args[1].func.ret_type, args[1].func.ret_ref);
+      for (std::size_t i = 0; i < size; i++) {
+        const Value element = arr.array_at(i);
+        const Value *call_args[] = {&element};
+        res.array_push(caller.call(call_args));
       }
-      Value res(Utils::STR);
-      const std::size_t str_len = args[1].string_value.length();
-      res.string_value = args[0].string_value.replace(index, str_len, args[2].string_value);
       return res;
     }
 };
 
-class NativeReplaceall : public NativeFunction {
+class NativeFilter : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
-      if (args.size() != 3 || args[0].type != Utils::STR || args[1].type != Utils::STR || args[2].type != Utils::STR) {
-        ErrorHandler::throw_runtime_error("replace_all() expects three arguments (str, str, str)", line);
+      FunctionCaller caller = array_callback(args, 2, 1, "filter", "(arr, func)", line, VM);
+      const Value &arr = args[0];
+      const std::size_t size = arr.array_size();
+      Value res(Utils::ARR);
+      res.array_type = arr.array_type;
+      res.packed_type = arr.packed_type;
+      for (std::size_t i = 0; i < size; i++) {
+        const Value element = arr.array_at(i);
+        const Value *call_args[] = {&element};
+        const Value keep = caller.call(call_args);
+        if (keep.type != Utils::BOOL) {
+          ErrorHandler::throw_runtime_error("filter() expects a function that returns a bool", line);
+        }
+        if (keep.boolean_value) {
+          res.array_push(element);
+        }
       }
-      Value res(Utils::STR);
-      res.string_value = std::regex_replace(
-        args[0].string_value,
-        std::regex(args[1].string_value),
-        args[2].string_value
-      );
       return res;
     }
 };
 
-class NativeTobytes : public NativeFunction {
+class NativeReduce : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      FunctionCaller caller = array_callback(args, 3, 2, "reduce", "(arr, func, any)", line, VM);
+      const Value &arr = args[0];
+      const std::size_t size = arr.array_size();
+      Value acc = args[2];
+      for (std::size_t i = 0; i < size; i++) {
+        const Value element = arr.array_at(i);
+        const Value *call_args[] = {&acc, &element};
+        acc = caller.call(call_args);
+      }
+      return acc;
+    }
+};
+
+class NativeForeach : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      FunctionCaller caller = array_callback(args, 2, 1, "for_each", "(arr, func)", line, VM);
+      const Value &arr = args[0];
+      const std::size_t size = arr.array_size();
+      for (std::size_t i = 0; i < size; i++) {
+        const Value element = arr.array_at(i);
+        const Value *call_args[] = {&element};
+        caller.call(call_args);
+      }
+      return {Utils::VOID};
+    }
+};
+
+static Value make_stream(const std::shared_ptr<Stream> &stream) {
+  Value res(Utils::STREAM);
+  res.handle = stream;
+  return res;
+}
+
+// adapters and terminals take a stream or an array, which is streamed
+static std::shared_ptr<Stream> stream_arg(const Value &val, const std::string &fn, const std::string &signature, std::int64_t line) {
+  if (val.type == Utils::STREAM) return std::static_pointer_cast<Stream>(val.handle);
+  if (val.type == Utils::ARR) return std::make_shared<ArrayStream>(val);
+  ErrorHandler::throw_runtime_error(fn + "() expects " + signature, line);
+  return nullptr;
+}
+
+static void check_stream_fn(const Value &val, std::size_t arity, const std::string &fn, const std::string &signature, std::int64_t line) {
+  if (val.type != Utils::FUNC) {
+    ErrorHandler::throw_runtime_error(fn + "() expects " + signature, line);
+  }
+  if (val.func.params.size() != arity) {
+    ErrorHandler::throw_runtime_error(fn + "() expects a function with " + std::to_string(arity) + (arity == 1 ? " parameter" : " parameters"), line);
+  }
+}
+
+// pulls every element of a stream, the functions of its adapters are called through the evaluator running the terminal
+template <typename Fn>
+static void consume_stream(Stream &stream, std::int64_t line, CVM &VM, Fn fn) {
+  stream.bind(VM.evaluator, line);
+  Value element;
+  while (stream.next(element)) {
+    fn(element);
+  }
+  stream.bind(nullptr, line);
+}
+
+class NativeStreamarray : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::ARR) {
+        ErrorHandler::throw_runtime_error("stream_array() expects one argument (arr)", line);
+      }
+      return make_stream(std::make_shared<ArrayStream>(args[0]));
+    }
+};
+
+class NativeRange : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() < 2 || args.size() > 3) {
+        ErrorHandler::throw_runtime_error("range() expects two or three arguments (int, int, [int])", line);
+      }
+      for (const auto &arg : args) {
+        if (arg.type != Utils::INT) {
+          ErrorHandler::throw_runtime_error("range() expects two or three arguments (int, int, [int])", line);
+        }
+      }
+      const std::int64_t step = args.size() == 3 ? args[2].number_value : 1;
+      if (step == 0) {
+        ErrorHandler::throw_runtime_error("range() step can't be 0", line);
+      }
+      return make_stream(std::make_shared<RangeStream>(args[0].number_value, args[1].number_value, step));
+    }
+};
+
+class NativeStreamlines : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
       if (args.size() != 1 || args[0].type != Utils::STR) {
-        ErrorHandler::throw_runtime_error("to_bytes() expects one argument (str)", line);
+        ErrorHandler::throw_runtime_error("file_lines() and stream_lines() expect one argument (str)", line);
+      }
+      auto stream = std::make_shared<LinesStream>(args[0].string_value);
+      if (!stream->good()) {
+        ErrorHandler::throw_runtime_error("couldn't read " + args[0].string_value, line);
+      }
+      return make_stream(stream);
+    }
+};
+
+class NativeStreammap : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      const std::string signature = "two arguments (stream|arr, func)";
+      if (args.size() != 2) {
+        ErrorHandler::throw_runtime_error("stream_map() expects " + signature, line);
+      }
+      auto source = stream_arg(args[0], "stream_map", signature, line);
+      check_stream_fn(args[1], 1, "stream_map", signature, line);
+      if (args[1].func.ret_type == "void") {
+        ErrorHandler::throw_runtime_error("stream_map() expects a function that returns a value", line);
+      }
+      return make_stream(std::make_shared<MapStream>(source, args[1]));
+    }
+};
+
+class NativeStreamfilter : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      const std::string signature = "two arguments (stream|arr, func)";
+      if (args.size() != 2) {
+        ErrorHandler::throw_runtime_error("stream_filter() expects " + signature, line);
+      }
+      auto source = stream_arg(args[0], "stream_filter", signature, line);
+      check_stream_fn(args[1], 1, "stream_filter", signature, line);
+      return make_stream(std::make_shared<FilterStream>(source, args[1]));
+    }
+};
+
+class NativeStreamtake : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      const std::string signature = "two arguments (stream|arr, int)";
+      if (args.size() != 2 || args[1].type != Utils::INT) {
+        ErrorHandler::throw_runtime_error("stream_take() expects " + signature, line);
+      }
+      auto source = stream_arg(args[0], "stream_take", signature, line);
+      return make_stream(std::make_shared<TakeStream>(source, args[1].number_value));
+    }
+};
+
+class NativeStreamskip : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      const std::string signature = "two arguments (stream|arr, int)";
+      if (args.size() != 2 || args[1].type != Utils::INT) {
+        ErrorHandler::throw_runtime_error("stream_skip() expects " + signature, line);
+      }
+      auto source = stream_arg(args[0], "stream_skip", signature, line);
+      return make_stream(std::make_shared<SkipStream>(source, args[1].number_value));
+    }
+};
+
+class NativeStreamzip : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      const std::string signature = "two or three arguments (stream|arr, stream|arr, [func])";
+      if (args.size() < 2 || args.size() > 3) {
+        ErrorHandler::throw_runtime_error("stream_zip() expects " + signature, line);
+      }
+      auto first = stream_arg(args[0], "stream_zip", signature, line);
+      auto second = stream_arg(args[1], "stream_zip", signature, line);
+      Value fn;
+      if (args.size() == 3) {
+        check_stream_fn(args[2], 2, "stream_zip", signature, line);
+        fn = args[2];
+      }
+      return make_stream(std::make_shared<ZipStream>(first, second, fn));
+    }
+};
+
+class NativeStreamcollect : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      const std::string signature = "one argument (stream)";
+      if (args.size() != 1) {
+        ErrorHandler::throw_runtime_error("stream_collect() expects " + signature, line);
       }
+      auto stream = stream_arg(args[0], "stream_collect", signature, line);
       Value res(Utils::ARR);
-      res.array_type = "int";
-      const char *c_str = args[0].string_value.c_str();
-      int i = 0;
-      while (c_str[i]) {
-        Value element;
-        element.type = Utils::INT;
-        element.number_value = (std::int64_t)c_str[i++];
-        res.array_values.push_back(element);
+      res.set_array_type(stream->element_type);
+      consume_stream(*stream, line, VM, [&](const Value &element) {
+        res.array_push(element);
+      });
+      return res;
+    }
+};
+
+class NativeStreamcount : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      const std::string signature = "one argument (stream)";
+      if (args.size() != 1) {
+        ErrorHandler::throw_runtime_error("stream_count() expects " + signature, line);
       }
+      auto stream = stream_arg(args[0], "stream_count", signature, line);
+      Value res(Utils::INT);
+      consume_stream(*stream, line, VM, [&](const Value &element) {
+        res.number_value++;
+      });
       return res;
     }
 };
 
-class NativeFrombytes : public NativeFunction {
+class NativeStreamsum : public NativeFunction {
   public:
     Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
-      if (args.size() != 1 || args[0].type != Utils::ARR) {
-        ErrorHandler::throw_runtime_error("from_bytes() expects one argument (arr)", line);
+      const std::string signature = "one argument (stream)";
+      if (args.size() != 1) {
+        ErrorHandler::throw_runtime_error("stream_sum() expects " + signature, line);
       }
-      if (args[0].array_type != "int") {
-        ErrorHandler::throw_runtime_error("from_bytes() expects an int array", line);
+      auto stream = stream_arg(args[0], "stream_sum", signature, line);
+      const bool floats = stream->element_type == "double";
+      if (!floats && stream->element_type != "int") {
+        ErrorHandler::throw_runtime_error("stream_sum() expects a stream of int or double", line);
       }
-      Value res(Utils::STR);
-      res.string_value = "";
-      for (auto &el : args[0].array_values) {
-        res.string_value += (char)el.number_value;
+      Value res(floats ? Utils::FLOAT : Utils::INT);
+      consume_stream(*stream, line, VM, [&](const Value &element) {
+        if (floats) {
+          res.float_value += element.float_value;
+        } else {
+          // wraps around on overflow like sum() does
+          res.number_value = (std::int64_t)((std::uint64_t)res.number_value + (std::uint64_t)element.number_value);
+        }
+      });
+      return res;
+    }
+};
+
+class NativeStreamreduce : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      const std::string signature = "three arguments (stream, func, any)";
+      if (args.size() != 3) {
+        ErrorHandler::throw_runtime_error("stream_reduce() expects " + signature, line);
+      }
+      auto stream = stream_arg(args[0], "stream_reduce", signature, line);
+      check_stream_fn(args[1], 2, "stream_reduce", signature, line);
+      FunctionCaller caller(*VM.evaluator, args[1]);
+      Value acc = args[2];
+      consume_stream(*stream, line, VM, [&](const Value &element) {
+        const Value *call_args[] = {&acc, &element};
+        acc = caller.call(call_args);
+      });
+      return acc;
+    }
+};
+
+class NativeRegexcompile : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || args[0].type != Utils::STR) {
+        ErrorHandler::throw_runtime_error("regex_compile() expects one argument (str)", line);
+      }
+      std::string error;
+      Value res(Utils::REGEX);
+      res.handle = Regex::compile(args[0].string_value.view(), error);
+      if (res.handle == nullptr) {
+        ErrorHandler::throw_runtime_error("regex_compile() got an invalid pattern, " + error, line);
+      }
+      return res;
+    }
+};
+
+static Regex &regex_args(std::vector<Value> &args, const std::string &fn, std::int64_t line) {
+  if (args.size() != 2 || args[0].type != Utils::REGEX || args[1].type != Utils::STR) {
+    ErrorHandler::throw_runtime_error(fn + "() expects two arguments (regex, str)", line);
+  }
+  return args[0].regex();
+}
+
+// the matched parts are views into the searched string
+static Value match_view(const Value &str, std::size_t start, std::size_t end) {
+  Value res(Utils::STR);
+  if (start != Regex::NO_MATCH) {
+    res.string_value = SharedString(str.string_value, start, end - start);
+  }
+  return res;
+}
+
+class NativeRegexmatch : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      Regex &regex = regex_args(args, "regex_match", line);
+      Value res(Utils::BOOL);
+      res.boolean_value = regex.match(args[1].string_value.view());
+      return res;
+    }
+};
+
+class NativeRegexsearch : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      Regex &regex = regex_args(args, "regex_search", line);
+      Value res(Utils::ARR);
+      res.set_array_type("str");
+      Regex::Captures captures;
+      if (!regex.search(args[1].string_value.view(), 0, captures)) {
+        return res;
+      }
+      ArrayStorage &storage = res.mut_array();
+      for (std::size_t group = 0; group < regex.groups(); group++) {
+        storage.values.push_back(match_view(args[1], captures[group * 2], captures[group * 2 + 1]));
+      }
+      return res;
+    }
+};
+
+class NativeRegexfindall : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      Regex &regex = regex_args(args, "regex_find_all", line);
+      Value res(Utils::ARR);
+      res.set_array_type("str");
+      ArrayStorage &storage = res.mut_array();
+      const std::string_view str = args[1].string_value.view();
+      Regex::Captures captures;
+      std::size_t from = 0;
+      while (regex.search(str, from, captures)) {
+        storage.values.push_back(match_view(args[1], captures[0], captures[1]));
+        // an empty match would be found again at the same position
+        from = captures[1] == captures[0] ? captures[1] + 1 : captures[1];
       }
       return res;
     }
@@ -674,17 +2562,18 @@ class NativeStacktrace : public NativeFunction {
       int printed = 0;
       for (auto crumb = VM.trace.stack.rbegin(); crumb != VM.trace.stack.rend(); crumb++) {
         if (printed > limit) {
-          std::cout << "    and " << (VM.trace.stack.size() - printed) << " more\n";
+          VM.output.append("    and " + std::to_string(VM.trace.stack.size() - printed) + " more\n");
           break;
         }
         std::string name = crumb->name.size() == 0 ? "<anonymous function>" : "function '" + crumb->name + "'";
-        std::cout << "  in " << name << " called on line " << crumb->line;
+        VM.output.append("  in " + name + " called on line " + std::to_string(crumb->line));
         if (crumb->source != nullptr) {
-          std::cout << " in file " << *crumb->source;
+          VM.output.append(" in file " + *crumb->source);
         }
-        std::cout << std::endl;
+        VM.output.append('\n');
         printed++;
       }
+      VM.output.written();
       return {Utils::VOID};
     }
 };
@@ -721,6 +2610,150 @@ class NativeSameref : public NativeFunction {
     }
 };
 
+class NativeSum : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || !is_numeric_array(args[0])) {
+        ErrorHandler::throw_runtime_error("sum() expects one argument (arr of int|double)", line);
+      }
+      const Value &arr = args[0];
+      if (arr.packed_type == Utils::INT) {
+        Value res(Utils::INT);
+        res.number_value = Simd::sum(arr.ints(), arr.array_size());
+        return res;
+      }
+      Value res(Utils::FLOAT);
+      res.float_value = Simd::sum(arr.floats(), arr.array_size());
+      return res;
+    }
+};
+
+class NativeMin : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || !is_numeric_array(args[0])) {
+        ErrorHandler::throw_runtime_error("min() expects one argument (arr of int|double)", line);
+      }
+      const Value &arr = args[0];
+      if (arr.array_size() == 0) {
+        ErrorHandler::throw_runtime_error("min() of an empty array", line);
+      }
+      if (arr.packed_type == Utils::INT) {
+        Value res(Utils::INT);
+        res.number_value = Simd::min(arr.ints(), arr.array_size());
+        return res;
+      }
+      Value res(Utils::FLOAT);
+      res.float_value = Simd::min(arr.floats(), arr.array_size());
+      return res;
+    }
+};
+
+class NativeMax : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 1 || !is_numeric_array(args[0])) {
+        ErrorHandler::throw_runtime_error("max() expects one argument (arr of int|double)", line);
+      }
+      const Value &arr = args[0];
+      if (arr.array_size() == 0) {
+        ErrorHandler::throw_runtime_error("max() of an empty array", line);
+      }
+      if (arr.packed_type == Utils::INT) {
+        Value res(Utils::INT);
+        res.number_value = Simd::max(arr.ints(), arr.array_size());
+        return res;
+      }
+      Value res(Utils::FLOAT);
+      res.float_value = Simd::max(arr.floats(), arr.array_size());
+      return res;
+    }
+};
+
+class NativeDot : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || !is_numeric_array(args[0]) || !is_numeric_array(args[1])) {
+        ErrorHandler::throw_runtime_error("dot() expects two arguments (arr of int|double, arr of int|double)", line);
+      }
+      if (args[0].array_size() != args[1].array_size()) {
+        ErrorHandler::throw_runtime_error("dot() arrays must have the same size", line);
+      }
+      if (args[0].packed_type == Utils::INT && args[1].packed_type == Utils::INT) {
+        Value res(Utils::INT);
+        res.number_value = Simd::dot(args[0].ints(), args[1].ints(), args[0].array_size());
+        return res;
+      }
+      promote_to_double(args[0]);
+      promote_to_double(args[1]);
+      Value res(Utils::FLOAT);
+      res.float_value = Simd::dot(args[0].floats(), args[1].floats(), args[0].array_size());
+      return res;
+    }
+};
+
+class NativeScale : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || !is_numeric_array(args[0]) || (args[1].type != Utils::INT && args[1].type != Utils::FLOAT)) {
+        ErrorHandler::throw_runtime_error("scale() expects two arguments (arr of int|double, int|double)", line);
+      }
+      Value &arr = args[0];
+      if (arr.packed_type == Utils::INT && args[1].type == Utils::INT) {
+        Simd::scale(arr.mut_ints(), arr.array_size(), args[1].number_value);
+        return std::move(arr);
+      }
+      double factor = args[1].float_value;
+      if (args[1].type == Utils::INT) factor = (double)args[1].number_value;
+      promote_to_double(arr);
+      Simd::scale(arr.mut_floats(), arr.array_size(), factor);
+      return std::move(arr);
+    }
+};
+
+class NativeAddarrays : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || !is_numeric_array(args[0]) || !is_numeric_array(args[1])) {
+        ErrorHandler::throw_runtime_error("add_arrays() expects two arguments (arr of int|double, arr of int|double)", line);
+      }
+      if (args[0].array_size() != args[1].array_size()) {
+        ErrorHandler::throw_runtime_error("add_arrays() arrays must have the same size", line);
+      }
+      Value &arr = args[0];
+      if (arr.packed_type == Utils::INT && args[1].packed_type == Utils::INT) {
+        Simd::add(arr.mut_ints(), args[1].ints(), arr.array_size());
+        return std::move(arr);
+      }
+      promote_to_double(arr);
+      promote_to_double(args[1]);
+      Simd::add(arr.mut_floats(), args[1].floats(), arr.array_size());
+      return std::move(arr);
+    }
+};
+
+class NativeFill : public NativeFunction {
+  public:
+    Value execute(std::vector<Value> &args, std::int64_t line, CVM &VM) {
+      if (args.size() != 2 || args[0].type != Utils::ARR || !args[0].is_packed()) {
+        ErrorHandler::throw_runtime_error("fill() expects two arguments (arr of int|double|bool, int|double|bool)", line);
+      }
+      Value &arr = args[0];
+      if (args[1].type != arr.packed_type) {
+        ErrorHandler::throw_runtime_error("Cannot fill an array of " + arr.array_type + "s with " + VM.stringify(args[1]), line);
+      }
+      if (arr.packed_type == Utils::INT) {
+        Simd::fill(arr.mut_ints(), arr.array_size(), args[1].number_value);
+      } else if (arr.packed_type == Utils::FLOAT) {
+        Simd::fill(arr.mut_floats(), arr.array_size(), args[1].float_value);
+      } else {
+        ArrayStorage &storage = arr.mut_array();
+        std::fill(storage.bools.begin(), storage.bools.end(), args[1].boolean_value);
+      }
+      return std::move(arr);
+    }
+};
+
 // used only for math functions
 
 REG_FN(NativeSin, sin)
@@ -738,9 +2771,13 @@ REG_FN(NativeCeil, ceil)
 REG_FN(NativeRound, round)
 
 void CVM::load_stdlib(void) {
-  globals.reserve(44);
+  globals.reserve(130);
   ADD_FN(NativeTimestamp, timestamp)
   ADD_FN(NativeInput, input)
+  ADD_FN(NativeInputall, input_all)
+  ADD_FN(NativeInputlines, input_lines)
+  ADD_FN(NativeReadint, read_int)
+  ADD_FN(NativeReaddouble, read_double)
   ADD_FN(NativePrint, print)
   ADD_FN(NativePrintln, println)
   ADD_FN(NativeFlush, flush)
@@ -764,23 +2801,105 @@ void CVM::load_stdlib(void) {
   ADD_FN(NativeRound, round)
   ADD_FN(NativePow, pow)
   ADD_FN(NativeFileread, file_read)
+  ADD_FN(NativeFilemap, file_map)
+  ADD_FN(NativeStreamlines, file_lines)
   ADD_FN(NativeFilewrite, file_write)
   ADD_FN(NativeFileexists, file_exists)
   ADD_FN(NativeFileremove, file_remove)
+  ADD_FN(NativeFileopen, file_open)
+  ADD_FN(NativeFilewritechunk, file_write_chunk)
+  ADD_FN(NativeFilereadchunk, file_read_chunk)
+  ADD_FN(NativeFileseek, file_seek)
+  ADD_FN(NativeFileclose, file_close)
+  ADD_FN(NativeCsvread, csv_read)
   ADD_FN(NativeAbs, abs)
   ADD_FN(NativeRand, rand)
   ADD_FN(NativeRandf, randf)
+  ADD_FN(NativeSeed, seed)
+  ADD_FN(NativeRandarray, rand_array)
+  ADD_FN(NativeRandfarray, randf_array)
   ADD_FN(NativeContains, contains)
   ADD_FN(NativeSubstr, substr)
   ADD_FN(NativeSplit, split)
+  ADD_FN(NativeSlice, slice)
   ADD_FN(NativeReplace, replace);
   ADD_FN(NativeReplaceall, replace_all);
   ADD_FN(NativeTobytes, to_bytes)
   ADD_FN(NativeFrombytes, from_bytes)
+  ADD_FN(NativeBuildernew, builder_new);
+  ADD_FN(NativeBuilderappend, builder_append);
+  ADD_FN(NativeBuilderstr, builder_str);
+  ADD_FN(NativeMapnew, map_new);
+  ADD_FN(NativeMapset, map_set);
+  ADD_FN(NativeMapget, map_get);
+  ADD_FN(NativeMaphas, map_has);
+  ADD_FN(NativeMapremove, map_remove);
+  ADD_FN(NativeMapkeys, map_keys);
+  ADD_FN(NativeMapvalues, map_values);
+  ADD_FN(NativeSetnew, set_new);
+  ADD_FN(NativeSetadd, set_add);
+  ADD_FN(NativeSetremove, set_remove);
+  ADD_FN(NativeSethas, set_has);
+  ADD_FN(NativeSetunion, set_union);
+  ADD_FN(NativeSetintersection, set_intersection);
+  ADD_FN(NativeSetdifference, set_difference);
+  ADD_FN(NativeSetvalues, set_values);
+  ADD_FN(NativeOmapnew, omap_new);
+  ADD_FN(NativeOmapset, omap_set);
+  ADD_FN(NativeOmapget, omap_get);
+  ADD_FN(NativeOmaphas, omap_has);
+  ADD_FN(NativeOmapremove, omap_remove);
+  ADD_FN(NativeOmapfloor, omap_floor);
+  ADD_FN(NativeOmapceil, omap_ceil);
+  ADD_FN(NativeOmaprange, omap_range);
+  ADD_FN(NativeOmaprangevalues, omap_range_values);
+  ADD_FN(NativeOmapkeys, omap_keys);
+  ADD_FN(NativeOmapvalues, omap_values);
+  ADD_FN(NativeDequenew, deque_new);
+  ADD_FN(NativeDequepushback, deque_push_back);
+  ADD_FN(NativeDequepushfront, deque_push_front);
+  ADD_FN(NativeDequepopback, deque_pop_back);
+  ADD_FN(NativeDequepopfront, deque_pop_front);
+  ADD_FN(NativeDequefront, deque_front);
+  ADD_FN(NativeDequeback, deque_back);
+  ADD_FN(NativeDequeget, deque_get);
+  ADD_FN(NativeDequevalues, deque_values);
+  ADD_FN(NativePqueuenew, pqueue_new);
+  ADD_FN(NativePqueuepush, pqueue_push);
+  ADD_FN(NativePqueuepop, pqueue_pop);
+  ADD_FN(NativePqueuepeek, pqueue_peek);
   ADD_FN(NativeBind, bind);
   ADD_FN(NativeClassname, class_name);
   ADD_FN(NativeArraytype, array_type);
   ADD_FN(NativeStacktrace, stack_trace);
   ADD_FN(NativeSleep, sleep);
   ADD_FN(NativeSameref, same_ref);
+  ADD_FN(NativeSum, sum);
+  ADD_FN(NativeMin, min);
+  ADD_FN(NativeMax, max);
+  ADD_FN(NativeDot, dot);
+  ADD_FN(NativeScale, scale);
+  ADD_FN(NativeAddarrays, add_arrays);
+  ADD_FN(NativeFill, fill);
+  ADD_FN(NativeSort, sort);
+  ADD_FN(NativeTransform, transform);
+  ADD_FN(NativeFilter, filter);
+  ADD_FN(NativeReduce, reduce);
+  ADD_FN(NativeForeach, for_each);
+  ADD_FN(NativeStreamarray, stream_array);
+  ADD_FN(NativeRange, range);
+  ADD_FN(NativeStreamlines, stream_lines);
+  ADD_FN(NativeStreammap, stream_map);
+  ADD_FN(NativeStreamfilter, stream_filter);
+  ADD_FN(NativeStreamtake, stream_take);
+  ADD_FN(NativeStreamskip, stream_skip);
+  ADD_FN(NativeStreamzip, stream_zip);
+  ADD_FN(NativeStreamcollect, stream_collect);
+  ADD_FN(NativeStreamcount, stream_count);
+  ADD_FN(NativeStreamsum, stream_sum);
+  ADD_FN(NativeStreamreduce, stream_reduce);
+  ADD_FN(NativeRegexcompile, regex_compile);
+  ADD_FN(NativeRegexmatch, regex_match);
+  ADD_FN(NativeRegexsearch, regex_search);
+  ADD_FN(NativeRegexfindall, regex_find_all);
 }
\ No newline at end of file
@@ -2,7 +2,10 @@
 #define __CVM_
 
 #include <map>
+#include <list>
 #include <unordered_map>
+#include <regex>
+#include <string_view>
 #include <vector>
 #include <string>
 #include <cstring>
@@ -10,33 +13,91 @@
 
 #include "utils.hpp"
 #include "AST.hpp"
+#include "strings.hpp"
+#include "files.hpp"
+#include "output.hpp"
 
 // Ckript Virtual Machine
 
+class ArrayStorage;
+class HashMap;
+class HashSet;
+class OrderedMap;
+class Deque;
+class PriorityQueue;
+class Stream;
+class Regex;
+
 class Value {
   public:
     Utils::VarType type = Utils::UNKNOWN;
     bool boolean_value = false;
     double float_value = 0.0;
-    std::string string_value = "";
+    SharedString string_value;
+    // builders, containers, streams and regexes are shared between all copies,
+    // what the handle points to is given by type
+    std::shared_ptr<void> handle;
     std::int64_t number_value = 0;
-    std::string reference_name = "";
+    Symbol reference_name;
     std::int64_t heap_reference = -1;
     std::int64_t this_ref = -1;
     FuncExpression func;
-    std::string func_name = "";
+    Symbol func_name;
     ParamList members;
-    std::map<std::string, Value> member_values;
-    std::vector<Value> array_values;
-    std::string array_type = "int";
-    std::string class_name = "";
-    std::string member_name = "";
+    std::map<Symbol, Value> member_values;
+    // arrays of ints, doubles and bools are stored unboxed
+    Utils::VarType packed_type = Utils::UNKNOWN;
+    // array elements are shared between copies and slices of an array until one of them is modified
+    std::shared_ptr<ArrayStorage> array_storage;
+    std::size_t array_offset = 0;
+    std::size_t array_length = 0;
+    bool is_slice = false;
+    Symbol array_type = default_array_type();
+    Symbol class_name;
+    Symbol member_name;
     bool is_lvalue() const;
+    static const Symbol &default_array_type(void);
+    // handle accessors, only valid for the matching type
+    std::string &builder() const { return *static_cast<std::string *>(handle.get()); }
+    HashMap &hash_map() const { return *static_cast<HashMap *>(handle.get()); }
+    HashSet &hash_set() const { return *static_cast<HashSet *>(handle.get()); }
+    OrderedMap &ordered_map() const { return *static_cast<OrderedMap *>(handle.get()); }
+    Deque &deque() const { return *static_cast<Deque *>(handle.get()); }
+    PriorityQueue &priority_queue() const { return *static_cast<PriorityQueue *>(handle.get()); }
+    Stream &stream() const { return *static_cast<Stream *>(handle.get()); }
+    Regex &regex() const { return *static_cast<Regex *>(handle.get()); }
+    // arrays
+    void set_array_type(const Symbol &_type, bool holds_refs = false);
+    bool is_packed() const;
+    void unpack(void);
+    std::size_t array_size() const;
+    Value array_at(std::size_t index) const;
+    const Value &array_ref(std::size_t index) const;
+    Value &array_mut(std::size_t index);
+    const std::int64_t *ints() const;
+    const double *floats() const;
+    std::int64_t *mut_ints();
+    double *mut_floats();
+    ArrayStorage &mut_array(void);
+    Value slice(std::size_t from, std::size_t length) const;
+    void array_set(std::size_t index, const Value &val);
+    void array_push(const Value &val);
+    void array_insert(std::size_t index, const Value &val);
+    void array_erase(std::size_t index);
+    void array_append(const Value &other);
     Value(void) : type(Utils::UNKNOWN) {};
     Value(Utils::VarType _type) : type(_type) {};
     Value(const FuncExpression &fn) : type(Utils::FUNC), func(fn) {}
 };
 
+class ArrayStorage {
+  public:
+    std::vector<Value> values;
+    std::vector<std::int64_t> ints;
+    std::vector<double> floats;
+    std::vector<bool> bools;
+};
+
 class Variable {
   public:
     std::string type;
@@ -97,16 +158,62 @@ class StackTrace {
     }
 };
 
+// compiled replace_all patterns, the least recently used one is dropped when the cache is full
+class RegexCache {
+  private:
+    static constexpr std::size_t CAPACITY = 64;
+    typedef std::pair<std::string, std::regex> Entry;
+    // most recently used first, list nodes don't move so the index can point into them
+    std::list<Entry> entries;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+  public:
+    const std::regex &get(const std::string &pattern);
+};
+
+// xoshiro256**, seeded once per VM so consecutive calls don't pay for a random_device each
+class Random {
+  private:
+    std::uint64_t state[4];
+  public:
+    Random(void);
+    // the same seed gives the same sequence
+    void seed(std::uint64_t value);
+    std::uint64_t next(void);
+    // uniform in [lo, hi], lo <= hi
+    std::int64_t between(std::int64_t lo, std::int64_t hi);
+    // uniform in [lo, hi)
+    double between(double lo, double hi);
+};
+
 class NativeFunction;
+class Evaluator;
 
 class CVM {
   private:
     void load_stdlib(void);
   public:
-    std::string stringify(Value &val);
+    // appends the text of val to out, nested values are written into the same buffer
+    void stringify(const Value &val, std::string &out);
+    std::string stringify(const Value &val) {
+      std::string out;
+      stringify(val, out);
+      return out;
+    }
     std::unordered_map<std::string, NativeFunction *> globals;
     Heap heap;
     StackTrace trace;
+    // standard output of print(), println() and runtime errors
+    OutputBuffer output;
+    // interpolation templates of interned strings, keyed by their address
+    std::unordered_map<const std::string *, StringTemplate> templates;
+    RegexCache regexes;
+    Random random;
+    // files opened by file_open(), closed when the interpreter exits
+    FileTable files;
+    // standard input of input() and the read_* natives
+    InputReader input;
+    // the evaluator that called the running native, natives call function values through it
+    Evaluator *evaluator = nullptr;
     CVM(void) {
       load_stdlib();
     }
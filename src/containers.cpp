@@ -0,0 +1,376 @@
+#include "containers.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+// multiply and fold, the same mixing step wyhash uses
+static inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+  const __uint128_t product = (__uint128_t)a * b;
+  return (std::uint64_t)product ^ (std::uint64_t)(product >> 64);
+}
+
+static const std::uint64_t SECRET0 = 0xa0761d6478bd642full;
+static const std::uint64_t SECRET1 = 0xe7037ed1a0b428dbull;
+static const std::uint64_t SECRET2 = 0x8ebc6af09c88c6e3ull;
+
+static inline std::uint64_t read64(const char *data) {
+  std::uint64_t val;
+  std::memcpy(&val, data, sizeof(val));
+  return val;
+}
+
+static inline std::uint64_t read32(const char *data) {
+  std::uint32_t val;
+  std::memcpy(&val, data, sizeof(val));
+  return val;
+}
+
+std::uint64_t hash_bytes(const char *data, std::size_t size) {
+  std::uint64_t seed = SECRET0 ^ size;
+  while (size > 16) {
+    seed = mix(read64(data) ^ SECRET1, read64(data + 8) ^ seed);
+    data += 16;
+    size -= 16;
+  }
+  std::uint64_t a = 0;
+  std::uint64_t b = 0;
+  if (size >= 8) {
+    a = read64(data);
+    b = read64(data + size - 8);
+  } else if (size >= 4) {
+    a = read32(data);
+    b = read32(data + size - 4);
+  } else if (size > 0) {
+    a = ((std::uint64_t)(unsigned char)data[0] << 16) | ((std::uint64_t)(unsigned char)data[size >> 1] << 8) | (unsigned char)data[size - 1];
+  }
+  return mix(mix(a ^ SECRET1, b ^ seed), size ^ SECRET2);
+}
+
+std::uint64_t hash_int(std::uint64_t n) {
+  return mix(n ^ SECRET0, SECRET1);
+}
+
+bool HashKey::hashable(const Value &val) {
+  if (val.heap_reference != -1) return false;
+  return val.type == Utils::INT || val.type == Utils::FLOAT || val.type == Utils::STR || val.type == Utils::BOOL;
+}
+
+HashKey::HashKey(const Value &val, bool hashed) : type(val.type) {
+  if (type == Utils::STR) {
+    string_value = val.string_value;
+    const std::string_view str = string_value.view();
+    if (hashed) hash = hash_bytes(str.data(), str.size());
+  } else if (type == Utils::FLOAT) {
+    // 0.0 and -0.0 are the same key
+    float_value = val.float_value == 0.0 ? 0.0 : val.float_value;
+    std::uint64_t bits;
+    std::memcpy(&bits, &float_value, sizeof(bits));
+    if (hashed) hash = hash_int(bits ^ SECRET2);
+  } else {
+    number_value = type == Utils::BOOL ? val.boolean_value : val.number_value;
+    if (hashed) hash = hash_int(number_value ^ type);
+  }
+}
+
+bool key_less(const HashKey &a, const HashKey &b) {
+  if (a.type == Utils::STR) return a.string_value.view() < b.string_value.view();
+  if (a.type == Utils::FLOAT) return a.float_value < b.float_value;
+  return a.number_value < b.number_value;
+}
+
+bool HashKey::operator==(const HashKey &other) const {
+  if (hash != other.hash || type != other.type) return false;
+  if (type == Utils::STR) return string_value == other.string_value;
+  if (type == Utils::FLOAT) return std::memcmp(&float_value, &other.float_value, sizeof(double)) == 0;
+  return number_value == other.number_value;
+}
+
+Value HashKey::to_value(void) const {
+  Value val(type);
+  if (type == Utils::STR) {
+    val.string_value = string_value;
+  } else if (type == Utils::FLOAT) {
+    val.float_value = float_value;
+  } else if (type == Utils::BOOL) {
+    val.boolean_value = number_value != 0;
+  } else {
+    val.number_value = number_value;
+  }
+  return val;
+}
+
+const char *type_name(Utils::VarType type) {
+  switch (type) {
+    case Utils::INT: return "int";
+    case Utils::FLOAT: return "double";
+    case Utils::STR: return "str";
+    case Utils::ARR: return "arr";
+    case Utils::OBJ: return "obj";
+    case Utils::BOOL: return "bool";
+    case Utils::FUNC: return "func";
+    case Utils::CLASS: return "class";
+    case Utils::BUILDER: return "builder";
+    case Utils::MAP: return "map";
+    case Utils::SET: return "hashset";
+    case Utils::OMAP: return "omap";
+    case Utils::DEQUE: return "deque";
+    case Utils::PQUEUE: return "pqueue";
+    case Utils::STREAM: return "stream";
+    case Utils::REGEX: return "regex";
+    default: return "void";
+  }
+}
+
+// index of the child that holds the key
+static std::size_t child_index(const BTreeNode *node, const HashKey &key) {
+  return std::upper_bound(node->keys.begin(), node->keys.end(), key, key_less) - node->keys.begin();
+}
+
+static std::size_t leaf_index(const BTreeNode *node, const HashKey &key) {
+  return std::lower_bound(node->keys.begin(), node->keys.end(), key, key_less) - node->keys.begin();
+}
+
+BTreeNode *OrderedMap::find_leaf(const HashKey &key) const {
+  BTreeNode *node = root.get();
+  while (!node->leaf) {
+    node = node->children[child_index(node, key)].get();
+  }
+  return node;
+}
+
+const Value *OrderedMap::find(const HashKey &key) const {
+  const BTreeNode *leaf = find_leaf(key);
+  const std::size_t i = leaf_index(leaf, key);
+  if (i == leaf->keys.size() || key_less(key, leaf->keys[i])) return nullptr;
+  return &leaf->values[i];
+}
+
+bool OrderedMap::set(const HashKey &key, const Value &value) {
+  HashKey split_key;
+  std::unique_ptr<BTreeNode> split_node;
+  const bool inserted = insert(root.get(), key, value, split_key, split_node);
+  if (split_node) {
+    // the root was split, the tree grows by one level
+    auto new_root = std::make_unique<BTreeNode>();
+    new_root->leaf = false;
+    new_root->keys.push_back(std::move(split_key));
+    new_root->children.push_back(std::move(root));
+    new_root->children.push_back(std::move(split_node));
+    root = std::move(new_root);
+  }
+  if (inserted) count++;
+  return inserted;
+}
+
+// inserts into the subtree, a node that overflows is split and its right half handed back to the parent
+bool OrderedMap::insert(BTreeNode *node, const HashKey &key, const Value &value, HashKey &split_key, std::unique_ptr<BTreeNode> &split_node) {
+  if (node->leaf) {
+    const std::size_t i = leaf_index(node, key);
+    if (i != node->keys.size() && !key_less(key, node->keys[i])) {
+      node->values[i] = value;
+      return false;
+    }
+    node->keys.insert(node->keys.begin() + i, key);
+    node->values.insert(node->values.begin() + i, value);
+    if (node->keys.size() > MAX_KEYS) {
+      const std::size_t half = node->keys.size() / 2;
+      auto right = std::make_unique<BTreeNode>();
+      right->keys.assign(std::make_move_iterator(node->keys.begin() + half), std::make_move_iterator(node->keys.end()));
+      right->values.assign(std::make_move_iterator(node->values.begin() + half), std::make_move_iterator(node->values.end()));
+      node->keys.resize(half);
+      node->values.resize(half);
+      right->next = node->next;
+      right->prev = node;
+      if (node->next != nullptr) node->next->prev = right.get();
+      node->next = right.get();
+      split_key = right->keys.front();
+      split_node = std::move(right);
+    }
+    return true;
+  }
+  const std::size_t i = child_index(node, key);
+  HashKey child_key;
+  std::unique_ptr<BTreeNode> child_split;
+  const bool inserted = insert(node->children[i].get(), key, value, child_key, child_split);
+  if (child_split) {
+    node->keys.insert(node->keys.begin() + i, std::move(child_key));
+    node->children.insert(node->children.begin() + i + 1, std::move(child_split));
+    if (node->keys.size() > MAX_KEYS) {
+      // the middle key moves up, it separates the two halves
+      const std::size_t mid = node->keys.size() / 2;
+      auto right = std::make_unique<BTreeNode>();
+      right->leaf = false;
+      right->keys.assign(std::make_move_iterator(node->keys.begin() + mid + 1), std::make_move_iterator(node->keys.end()));
+      right->children.assign(std::make_move_iterator(node->children.begin() + mid + 1), std::make_move_iterator(node->children.end()));
+      split_key = std::move(node->keys[mid]);
+      node->keys.resize(mid);
+      node->children.resize(mid + 1);
+      split_node = std::move(right);
+    }
+  }
+  return inserted;
+}
+
+bool OrderedMap::erase(const HashKey &key) {
+  if (!erase(root.get(), key)) return false;
+  count--;
+  // the root lost its last separator, the tree shrinks by one level
+  if (!root->leaf && root->keys.empty()) {
+    root = std::move(root->children.front());
+  }
+  return true;
+}
+
+bool OrderedMap::erase(BTreeNode *node, const HashKey &key) {
+  if (node->leaf) {
+    const std::size_t i = leaf_index(node, key);
+    if (i == node->keys.size() || key_less(key, node->keys[i])) return false;
+    node->keys.erase(node->keys.begin() + i);
+    node->values.erase(node->values.begin() + i);
+    return true;
+  }
+  const std::size_t i = child_index(node, key);
+  if (!erase(node->children[i].get(), key)) return false;
+  if (node->children[i]->keys.size() < MIN_KEYS) {
+    rebalance(node, i);
+  }
+  return true;
+}
+
+// refills a child that has too few keys from a sibling, or merges it with one
+// separators of removed leaf keys can stay in the inner nodes, they still split the key ranges correctly
+void OrderedMap::rebalance(BTreeNode *parent, std::size_t index) {
+  BTreeNode *child = parent->children[index].get();
+  BTreeNode *left = index > 0 ? parent->children[index - 1].get() : nullptr;
+  BTreeNode *right = index + 1 < parent->children.size() ? parent->children[index + 1].get() : nullptr;
+  if (left != nullptr && left->keys.size() > MIN_KEYS) {
+    if (child->leaf) {
+      child->keys.insert(child->keys.begin(), std::move(left->keys.back()));
+      child->values.insert(child->values.begin(), std::move(left->values.back()));
+      left->values.pop_back();
+      parent->keys[index - 1] = child->keys.front();
+    } else {
+      child->keys.insert(child->keys.begin(), std::move(parent->keys[index - 1]));
+      child->children.insert(child->children.begin(), std::move(left->children.back()));
+      left->children.pop_back();
+      parent->keys[index - 1] = std::move(left->keys.back());
+    }
+    left->keys.pop_back();
+    return;
+  }
+  if (right != nullptr && right->keys.size() > MIN_KEYS) {
+    if (child->leaf) {
+      child->keys.push_back(std::move(right->keys.front()));
+      child->values.push_back(std::move(right->values.front()));
+      right->values.erase(right->values.begin());
+      right->keys.erase(right->keys.begin());
+      parent->keys[index] = right->keys.front();
+    } else {
+      child->keys.push_back(std::move(parent->keys[index]));
+      child->children.push_back(std::move(right->children.front()));
+      right->children.erase(right->children.begin());
+      parent->keys[index] = std::move(right->keys.front());
+      right->keys.erase(right->keys.begin());
+    }
+    return;
+  }
+  // both siblings are at the minimum, merge the right one of the pair into the left one
+  if (right == nullptr) {
+    right = child;
+    child = left;
+    index--;
+  }
+  if (child->leaf) {
+    std::move(right->keys.begin(), right->keys.end(), std::back_inserter(child->keys));
+    std::move(right->values.begin(), right->values.end(), std::back_inserter(child->values));
+    child->next = right->next;
+    if (right->next != nullptr) right->next->prev = child;
+  } else {
+    child->keys.push_back(std::move(parent->keys[index]));
+    std::move(right->keys.begin(), right->keys.end(), std::back_inserter(child->keys));
+    std::move(right->children.begin(), right->children.end(), std::back_inserter(child->children));
+  }
+  parent->keys.erase(parent->keys.begin() + index);
+  parent->children.erase(parent->children.begin() + index + 1);
+}
+
+void OrderedMap::Position::next(void) {
+  if (++index < node->keys.size()) return;
+  node = node->next;
+  index = 0;
+}
+
+OrderedMap::Position OrderedMap::begin(void) const {
+  const BTreeNode *node = root.get();
+  while (!node->leaf) {
+    node = node->children.front().get();
+  }
+  Position pos;
+  if (!node->keys.empty()) pos.node = node;
+  return pos;
+}
+
+OrderedMap::Position OrderedMap::lower_bound(const HashKey &key) const {
+  const BTreeNode *leaf = find_leaf(key);
+  Position pos;
+  pos.index = leaf_index(leaf, key);
+  pos.node = leaf;
+  // every leaf but the root has keys, so the next one starts with the first bigger key
+  if (pos.index == leaf->keys.size()) {
+    pos.node = leaf->next;
+    pos.index = 0;
+  }
+  return pos;
+}
+
+OrderedMap::Position OrderedMap::floor(const HashKey &key) const {
+  const BTreeNode *leaf = find_leaf(key);
+  std::size_t i = child_index(leaf, key);
+  Position pos;
+  if (i > 0) {
+    pos.node = leaf;
+    pos.index = i - 1;
+  } else if (leaf->prev != nullptr) {
+    pos.node = leaf->prev;
+    pos.index = leaf->prev->keys.size() - 1;
+  }
+  return pos;
+}
+
+void Deque::grow(void) {
+  std::vector<Value> bigger(buffer.empty() ? 8 : buffer.size() * 2);
+  for (std::size_t i = 0; i < count; i++) {
+    bigger[i] = std::move(at(i));
+  }
+  buffer.swap(bigger);
+  head = 0;
+}
+
+void Deque::push_back(const Value &val) {
+  if (count == buffer.size()) grow();
+  count++;
+  at(count - 1) = val;
+}
+
+void Deque::push_front(const Value &val) {
+  if (count == buffer.size()) grow();
+  head = (head - 1) & (buffer.size() - 1);
+  count++;
+  at(0) = val;
+}
+
+// popped slots are reset so they don't keep strings or arrays alive
+Value Deque::pop_back(void) {
+  Value val = std::move(at(count - 1));
+  at(count - 1) = Value();
+  count--;
+  return val;
+}
+
+Value Deque::pop_front(void) {
+  Value val = std::move(at(0));
+  at(0) = Value();
+  head = (head + 1) & (buffer.size() - 1);
+  count--;
+  return val;
+}
@@ -0,0 +1,256 @@
+#if !defined(__CONTAINERS_)
+#define __CONTAINERS_
+
+#include "CVM.hpp"
+#include "utils.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+// Native containers.
+// A container value is a handle, all copies of it refer to the same container.
+
+std::uint64_t hash_bytes(const char *data, std::size_t size);
+std::uint64_t hash_int(std::uint64_t n);
+
+// key of a map or element of a set, ints, doubles, bools and strings can be hashed
+class HashKey {
+  public:
+    Utils::VarType type = Utils::UNKNOWN;
+    std::int64_t number_value = 0;
+    double float_value = 0.0;
+    SharedString string_value;
+    std::uint64_t hash = 0;
+    static bool hashable(const Value &val);
+    Value to_value(void) const;
+    bool operator==(const HashKey &other) const;
+    HashKey(void) {};
+    // keys of ordered maps are only compared, they don't need a hash
+    HashKey(const Value &val, bool hashed = true);
+};
+
+// orders two keys of the same type
+bool key_less(const HashKey &a, const HashKey &b);
+
+// open addressing with linear probing, the slots point into a dense vector of entries,
+// so iterating goes over the entries in insertion order (until one is removed)
+template <typename Entry>
+class HashTable {
+  private:
+    // 0 is an empty slot, otherwise the index of the entry + 1
+    std::vector<std::uint32_t> slots;
+    std::size_t find_slot(const HashKey &key) const {
+      const std::size_t mask = slots.size() - 1;
+      std::size_t slot = key.hash & mask;
+      while (slots[slot] != 0 && !(entries[slots[slot] - 1].key == key)) {
+        slot = (slot + 1) & mask;
+      }
+      return slot;
+    }
+    void grow(void) {
+      std::vector<std::uint32_t> old_slots(slots.size() == 0 ? 8 : slots.size() * 2, 0);
+      slots.swap(old_slots);
+      const std::size_t mask = slots.size() - 1;
+      for (std::size_t i = 0; i < entries.size(); i++) {
+        std::size_t slot = entries[i].key.hash & mask;
+        while (slots[slot] != 0) slot = (slot + 1) & mask;
+        slots[slot] = i + 1;
+      }
+    }
+  public:
+    std::vector<Entry> entries;
+    std::size_t size(void) const {
+      return entries.size();
+    }
+    Entry *find(const HashKey &key) {
+      if (entries.empty()) return nullptr;
+      const std::size_t slot = find_slot(key);
+      return slots[slot] == 0 ? nullptr : &entries[slots[slot] - 1];
+    }
+    // returns the entry with this key, adding it if it's not there yet
+    Entry &insert(const HashKey &key, bool &inserted) {
+      // keep the load factor under 3/4
+      if ((entries.size() + 1) * 4 > slots.size() * 3) grow();
+      const std::size_t slot = find_slot(key);
+      inserted = slots[slot] == 0;
+      if (inserted) {
+        entries.emplace_back();
+        entries.back().key = key;
+        slots[slot] = entries.size();
+      }
+      return entries[slots[slot] - 1];
+    }
+    bool erase(const HashKey &key) {
+      if (entries.empty()) return false;
+      const std::size_t mask = slots.size() - 1;
+      std::size_t hole = find_slot(key);
+      if (slots[hole] == 0) return false;
+      const std::size_t index = slots[hole] - 1;
+      // shift the following entries of the cluster back instead of leaving a tombstone
+      std::size_t slot = hole;
+      while (true) {
+        slot = (slot + 1) & mask;
+        if (slots[slot] == 0) break;
+        const std::size_t home = entries[slots[slot] - 1].key.hash & mask;
+        const bool movable = hole <= slot ? (home <= hole || home > slot) : (home <= hole && home > slot);
+        if (movable) {
+          slots[hole] = slots[slot];
+          hole = slot;
+        }
+      }
+      slots[hole] = 0;
+      // move the last entry into the gap
+      const std::size_t last = entries.size() - 1;
+      if (index != last) {
+        std::size_t moved = entries[last].key.hash & mask;
+        while (slots[moved] != last + 1) moved = (moved + 1) & mask;
+        slots[moved] = index + 1;
+        entries[index] = std::move(entries[last]);
+      }
+      entries.pop_back();
+      return true;
+    }
+    void reserve(std::size_t size) {
+      entries.reserve(size);
+      while (size * 4 > slots.size() * 3) grow();
+    }
+};
+
+class MapEntry {
+  public:
+    HashKey key;
+    Value value;
+};
+
+class HashMap : public HashTable<MapEntry> {
+  public:
+    // set by the first insertion, every key and value has to be of the same type
+    Utils::VarType key_type = Utils::UNKNOWN;
+    Utils::VarType value_type = Utils::UNKNOWN;
+};
+
+class SetEntry {
+  public:
+    HashKey key;
+};
+
+class HashSet : public HashTable<SetEntry> {
+  public:
+    // set by the first insertion, every element has to be of the same type
+    Utils::VarType element_type = Utils::UNKNOWN;
+};
+
+// B+ tree, every node keeps its keys in one vector so a search scans contiguous memory
+// the values are only stored in the leaves, which are linked in key order for range scans
+class BTreeNode {
+  public:
+    bool leaf = true;
+    std::vector<HashKey> keys;
+    // leaves only
+    std::vector<Value> values;
+    BTreeNode *prev = nullptr;
+    BTreeNode *next = nullptr;
+    // inner nodes only, children[i] holds the keys from keys[i - 1] up to (excluding) keys[i]
+    std::vector<std::unique_ptr<BTreeNode>> children;
+};
+
+class OrderedMap {
+  private:
+    std::unique_ptr<BTreeNode> root = std::make_unique<BTreeNode>();
+    std::size_t count = 0;
+    BTreeNode *find_leaf(const HashKey &key) const;
+    bool insert(BTreeNode *node, const HashKey &key, const Value &value, HashKey &split_key, std::unique_ptr<BTreeNode> &split_node);
+    bool erase(BTreeNode *node, const HashKey &key);
+    void rebalance(BTreeNode *parent, std::size_t index);
+  public:
+    static constexpr std::size_t MAX_KEYS = 32;
+    static constexpr std::size_t MIN_KEYS = MAX_KEYS / 2;
+    // position of an entry, node is null past the last entry
+    class Position {
+      public:
+        const BTreeNode *node = nullptr;
+        std::size_t index = 0;
+        bool valid(void) const { return node != nullptr; }
+        const HashKey &key(void) const { return node->keys[index]; }
+        const Value &value(void) const { return node->values[index]; }
+        void next(void);
+    };
+    // set by the first insertion, every key and value has to be of the same type
+    Utils::VarType key_type = Utils::UNKNOWN;
+    Utils::VarType value_type = Utils::UNKNOWN;
+    std::size_t size(void) const { return count; }
+    const Value *find(const HashKey &key) const;
+    // returns whether the key is new, otherwise its value is replaced
+    bool set(const HashKey &key, const Value &value);
+    bool erase(const HashKey &key);
+    Position begin(void) const;
+    // first entry with a key >= key
+    Position lower_bound(const HashKey &key) const;
+    // last entry with a key <= key
+    Position floor(const HashKey &key) const;
+};
+
+// ring buffer, the capacity is a power of two so positions wrap with a mask
+class Deque {
+  private:
+    std::vector<Value> buffer;
+    std::size_t head = 0;
+    std::size_t count = 0;
+    void grow(void);
+  public:
+    // set by the first insertion, every element has to be of the same type
+    Utils::VarType element_type = Utils::UNKNOWN;
+    std::size_t size(void) const { return count; }
+    const Value &at(std::size_t index) const { return buffer[(head + index) & (buffer.size() - 1)]; }
+    Value &at(std::size_t index) { return buffer[(head + index) & (buffer.size() - 1)]; }
+    void push_back(const Value &val);
+    void push_front(const Value &val);
+    Value pop_back(void);
+    Value pop_front(void);
+};
+
+// binary min heap, less decides which of two elements comes out first
+class PriorityQueue {
+  public:
+    // set by the first insertion, every element has to be of the same type
+    Utils::VarType element_type = Utils::UNKNOWN;
+    // optional Ckript function (a, b) bool, true when a comes out before b
+    Value comparator;
+    std::vector<Value> heap;
+    std::size_t size(void) const { return heap.size(); }
+    template <typename Less>
+    void push(const Value &val, Less less) {
+      heap.push_back(val);
+      std::size_t i = heap.size() - 1;
+      while (i > 0) {
+        const std::size_t parent = (i - 1) / 2;
+        if (!less(heap[i], heap[parent])) break;
+        std::swap(heap[i], heap[parent]);
+        i = parent;
+      }
+    }
+    template <typename Less>
+    Value pop(Less less) {
+      Value top = std::move(heap.front());
+      heap.front() = std::move(heap.back());
+      heap.pop_back();
+      std::size_t i = 0;
+      while (true) {
+        const std::size_t left = i * 2 + 1;
+        if (left >= heap.size()) break;
+        std::size_t child = left;
+        if (left + 1 < heap.size() && less(heap[left + 1], heap[left])) child = left + 1;
+        if (!less(heap[child], heap[i])) break;
+        std::swap(heap[i], heap[child]);
+        i = child;
+      }
+      return top;
+    }
+};
+
+// name of the type as used in declarations
+const char *type_name(Utils::VarType type);
+
+#endif // __CONTAINERS_
@@ -0,0 +1,205 @@
+#include "csv.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+// every thread gets at least this many bytes, otherwise starting it costs more than it saves
+static const std::size_t MIN_CHUNK = 1 << 20;
+
+// the columns of one chunk of the file
+class CsvChunk {
+  public:
+    std::vector<CsvColumn> columns;
+    // line ends in the chunk, the lines of the chunks after it are numbered from them
+    std::size_t lines = 0;
+    bool failed = false;
+    // counted from the start of the chunk
+    std::size_t error_line = 0;
+    std::string error;
+    bool fail(std::size_t line, const std::string &message) {
+      failed = true;
+      error_line = line;
+      error = message;
+      return false;
+    }
+};
+
+static std::string_view trim(std::string_view field) {
+  while (!field.empty() && field.front() == ' ') field.remove_prefix(1);
+  while (!field.empty() && field.back() == ' ') field.remove_suffix(1);
+  return field;
+}
+
+static bool add_field(CsvColumn &column, std::string_view field, bool escaped, const std::shared_ptr<const void> &owner) {
+  if (column.type == Utils::INT) {
+    std::int64_t number;
+    if (!parse_number(trim(field), number)) return false;
+    column.ints.push_back(number);
+  } else if (column.type == Utils::FLOAT) {
+    double number;
+    if (!parse_number(trim(field), number)) return false;
+    column.floats.push_back(number);
+  } else {
+    column.strings.emplace_back(Utils::STR);
+    // unescaped fields were copied out of the file, the rest stay views into it
+    column.strings.back().string_value = escaped ? SharedString(std::string(field)) : SharedString(owner, field);
+  }
+  return true;
+}
+
+static bool parse_chunk(std::string_view data, const std::shared_ptr<const void> &owner, CsvChunk &chunk) {
+  std::vector<CsvColumn> &columns = chunk.columns;
+  const std::size_t size = data.size();
+  const std::string count = std::to_string(columns.size());
+  // values are big, growing the string columns would move every one of them a few times
+  const std::size_t rows = std::count(data.begin(), data.end(), '\n') + 1;
+  for (CsvColumn &column : columns) {
+    if (column.type == Utils::INT) column.ints.reserve(rows);
+    else if (column.type == Utils::FLOAT) column.floats.reserve(rows);
+    else column.strings.reserve(rows);
+  }
+  std::string unescaped;
+  std::size_t pos = 0;
+  while (pos < size) {
+    // blank lines are skipped
+    if (data[pos] == '\n' || (data[pos] == '\r' && pos + 1 < size && data[pos + 1] == '\n')) {
+      pos += data[pos] == '\r' ? 2 : 1;
+      chunk.lines++;
+      continue;
+    }
+    const std::size_t line = chunk.lines + 1;
+    for (std::size_t c = 0; c < columns.size(); c++) {
+      std::string_view field;
+      bool escaped = false;
+      if (pos < size && data[pos] == '"') {
+        const std::size_t start = ++pos;
+        unescaped.clear();
+        while (true) {
+          const char *quote = (const char *)std::memchr(data.data() + pos, '"', size - pos);
+          if (quote == nullptr) return chunk.fail(line, "unterminated quoted field in column " + columns[c].name);
+          const std::size_t end = quote - data.data();
+          chunk.lines += std::count(data.data() + pos, quote, '\n');
+          // a doubled quote stands for one quote
+          if (end + 1 < size && data[end + 1] == '"') {
+            unescaped.append(data.data() + pos, end + 1 - pos);
+            pos = end + 2;
+            escaped = true;
+            continue;
+          }
+          unescaped.append(data.data() + pos, end - pos);
+          field = escaped ? std::string_view(unescaped) : data.substr(start, end - start);
+          pos = end + 1;
+          break;
+        }
+      } else {
+        std::size_t end = pos;
+        while (end < size && data[end] != ',' && data[end] != '\n') end++;
+        field = data.substr(pos, end - pos);
+        pos = end;
+        if (!field.empty() && field.back() == '\r' && (pos == size || data[pos] == '\n')) field.remove_suffix(1);
+      }
+      if (c + 1 != columns.size()) {
+        if (pos >= size || data[pos] != ',') return chunk.fail(line, "expected " + count + " fields, found " + std::to_string(c + 1));
+        pos++;
+      } else {
+        if (pos < size && data[pos] == '\r') pos++;
+        if (pos < size && data[pos] != '\n') return chunk.fail(line, "expected " + count + " fields, found more");
+        pos++;
+        chunk.lines++;
+      }
+      if (!add_field(columns[c], field, escaped, owner)) {
+        const char *expected = columns[c].type == Utils::INT ? "an int" : "a double";
+        return chunk.fail(line, "column " + columns[c].name + " expected " + expected + ", got '" + std::string(field.substr(0, 64)) + "'");
+      }
+    }
+  }
+  return true;
+}
+
+// the first line is a header if its fields are the names of the columns
+static bool is_header(std::string_view line, const std::vector<CsvColumn> &columns) {
+  if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  for (std::size_t c = 0; c < columns.size(); c++) {
+    const std::size_t comma = c + 1 == columns.size() ? line.size() : line.find(',');
+    if (comma == std::string_view::npos) return false;
+    std::string_view name = trim(line.substr(0, comma));
+    if (name.size() >= 2 && name.front() == '"' && name.back() == '"') name = name.substr(1, name.size() - 2);
+    if (name != columns[c].name.str()) return false;
+    line.remove_prefix(std::min(comma + 1, line.size()));
+  }
+  return true;
+}
+
+// moves the values of every chunk into one column
+template <typename T>
+static void join_column(std::vector<T> &to, std::vector<CsvChunk> &chunks, std::vector<T> CsvColumn::*part, std::size_t index) {
+  if (chunks.size() == 1) {
+    to = std::move(chunks[0].columns[index].*part);
+    return;
+  }
+  std::size_t total = 0;
+  for (CsvChunk &chunk : chunks) total += (chunk.columns[index].*part).size();
+  to.reserve(total);
+  for (CsvChunk &chunk : chunks) {
+    std::vector<T> &from = chunk.columns[index].*part;
+    to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+  }
+}
+
+bool Csv::parse(const std::shared_ptr<MappedFile> &file, std::vector<CsvColumn> &columns, std::string &error) {
+  const std::string_view data = file->view();
+  std::size_t start = 0;
+  std::size_t header_lines = 0;
+  const std::size_t first_line_end = std::min(data.find('\n'), data.size());
+  if (is_header(data.substr(0, first_line_end), columns)) {
+    start = std::min(first_line_end + 1, data.size());
+    header_lines = 1;
+  }
+  const std::size_t size = data.size() - start;
+  std::size_t chunks = std::min<std::size_t>(std::thread::hardware_concurrency(), size / MIN_CHUNK);
+  if (size < PARALLEL_THRESHOLD || chunks < 2 || std::memchr(data.data() + start, '"', size) != nullptr) {
+    chunks = 1;
+  }
+  // chunks end after a line end
+  std::vector<std::size_t> bounds(chunks + 1, data.size());
+  bounds[0] = start;
+  for (std::size_t i = 1; i < chunks; i++) {
+    std::size_t bound = std::max(start + size * i / chunks, bounds[i - 1]);
+    const std::size_t line_end = data.find('\n', bound);
+    bounds[i] = line_end == std::string_view::npos ? data.size() : line_end + 1;
+  }
+  std::vector<CsvChunk> results(chunks);
+  for (CsvChunk &chunk : results) {
+    for (const CsvColumn &column : columns) {
+      chunk.columns.emplace_back(column.name, column.type);
+    }
+  }
+  if (chunks == 1) {
+    parse_chunk(data.substr(start), file, results[0]);
+  } else {
+    std::vector<std::thread> threads;
+    threads.reserve(chunks);
+    for (std::size_t i = 0; i < chunks; i++) {
+      threads.emplace_back([&, i]() {
+        parse_chunk(data.substr(bounds[i], bounds[i + 1] - bounds[i]), file, results[i]);
+      });
+    }
+    for (auto &thread : threads) thread.join();
+  }
+  std::size_t line = header_lines;
+  for (CsvChunk &chunk : results) {
+    if (chunk.failed) {
+      error = "line " + std::to_string(line + chunk.error_line) + ": " + chunk.error;
+      return false;
+    }
+    line += chunk.lines;
+  }
+  for (std::size_t c = 0; c < columns.size(); c++) {
+    if (columns[c].type == Utils::INT) join_column(columns[c].ints, results, &CsvColumn::ints, c);
+    else if (columns[c].type == Utils::FLOAT) join_column(columns[c].floats, results, &CsvColumn::floats, c);
+    else join_column(columns[c].strings, results, &CsvColumn::strings, c);
+  }
+  return true;
+}
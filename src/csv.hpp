@@ -0,0 +1,38 @@
+#if !defined(__CSV_)
+#define __CSV_
+
+#include "CVM.hpp"
+#include "files.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Parsing of CSV files for the csv_read() native.
+// The mapped file is split at line ends into one chunk per hardware thread, every chunk is parsed into its own columns
+// and the columns are joined in order. Numbers are parsed with from_chars, strings are views into the mapping.
+// Quoted fields ("a, b" and "say ""hi""") are supported, but a line end can be quoted too, so files with quotes are parsed on one thread.
+
+class CsvColumn {
+  public:
+    Symbol name;
+    // INT, FLOAT or STR
+    Utils::VarType type;
+    std::vector<std::int64_t> ints;
+    std::vector<double> floats;
+    std::vector<Value> strings;
+    CsvColumn(const Symbol &_name, Utils::VarType _type) : name(_name), type(_type) {};
+};
+
+class Csv {
+  public:
+    // smaller files are parsed on the calling thread
+    static constexpr std::size_t PARALLEL_THRESHOLD = 1 << 22;
+    // appends every record of the file to the columns, a first line with the names of the columns is skipped
+    // returns false and sets error at the first field that doesn't fit its column
+    static bool parse(const std::shared_ptr<MappedFile> &file, std::vector<CsvColumn> &columns, std::string &error);
+};
+
+#endif // __CSV_
@@ -1,16 +1,17 @@
 #include "error-handler.hpp"
+#include "output.hpp"
 
 #include <string>
-#include <iostream>
 #include <cstdlib>
 #include <cstdint>
 
 void ErrorHandler::throw_generic_error(const std::string &cause, std::uint32_t line) {
-  std::cout << cause;
+  std::string message = cause;
   if (line != 0) {
-    std::cout << " (line " << line << ")";
+    message += " (line " + std::to_string(line) + ")";
   }
-  std::cout << std::endl;
+  message += '\n';
+  OutputBuffer::write_error(message);
   std::exit(EXIT_FAILURE);
 }
 
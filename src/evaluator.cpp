@@ -1,11 +1,11 @@
 #include "evaluator.hpp"
+#include "streams.hpp"
 #include "utils.hpp"
 #include "error-handler.hpp"
 #include "CVM.hpp"
 
 #include <iostream>
 #include <cassert>
-#include <regex>
 #include <memory>
 
 #define FLAG_OK 0
@@ -16,8 +16,6 @@
 
 typedef Statement::StmtType StmtType;
 typedef Utils::VarType VarType;
-typedef std::shared_ptr<RpnElement> SharedRpnElement;
-typedef std::vector<SharedRpnElement> SharedRpnStack;
 
 #define SHARE_RPN(rpn) std::make_shared<RpnElement>(rpn)
 
@@ -38,9 +36,10 @@ typedef std::vector<SharedRpnElement> SharedRpnStack;
 
 void Evaluator::throw_error(const std::string &cause) {
   if (current_source != nullptr) {
-    std::cout << "(" << *current_source << ") ";
+    VM.output.append("(" + *current_source + ") ");
   }
-  std::cout << "Runtime error: " << cause << " (line " << current_line << ")\n";
+  VM.output.append("Runtime error: " + cause + " (line " + std::to_string(current_line) + ")\n");
+  // the output is flushed at exit
   if (VM.trace.stack.size() == 0) std::exit(EXIT_FAILURE);
   std::vector<Value> args;
   VM.globals.at("stack_trace")->execute(args, current_line, VM);
@@ -66,7 +65,7 @@ int Evaluator::execute_statement(const Node &statement) {
     return FLAG_OK;
   } else if (statement.stmt.type == StmtType::EXPR) {
     if (statement.stmt.expressions.size() != 1) return FLAG_OK;
-    evaluate_expression(statement.stmt.expressions[0]);
+    execute_expression(statement.stmt.expressions[0]);
     return FLAG_OK;
   } else if (statement.stmt.type == StmtType::CLASS) {
     register_class(statement.stmt.class_stmt);
@@ -90,8 +89,8 @@ int Evaluator::execute_statement(const Node &statement) {
     }
     return FLAG_OK;
   } else if (statement.stmt.type == StmtType::BREAK) {
-    if (!nested_loops) {
-      throw_error("break statement outside of loops is illegal");
+    if (!nested_loops && !nested_switches) {
+      throw_error("break statement outside of loops and switches is illegal");
     }
     return FLAG_BREAK;
   } else if (statement.stmt.type == StmtType::CONTINUE) {
@@ -135,7 +134,7 @@ int Evaluator::execute_statement(const Node &statement) {
     }
     if (statement.stmt.statements.size() == 0) return FLAG_OK; // might cause bugs
     if (statement.stmt.expressions[0].size() != 0) {
-      evaluate_expression(statement.stmt.expressions[0]);
+      execute_expression(statement.stmt.expressions[0]);
     }
     nested_loops++;
     const NodeList &cond = statement.stmt.expressions[1];
@@ -154,11 +153,15 @@ int Evaluator::execute_statement(const Node &statement) {
       if (flag == FLAG_RETURN) return flag;
       const NodeList &increment_expr = statement.stmt.expressions[2];
       if (increment_expr.size() != 0) {
-        evaluate_expression(increment_expr);
+        execute_expression(increment_expr);
       }
     }
     nested_loops--;
     return FLAG_OK;
+  } else if (statement.stmt.type == StmtType::FOR_EACH) {
+    return execute_for_each(statement.stmt);
+  } else if (statement.stmt.type == StmtType::SWITCH) {
+    return execute_switch(statement.stmt);
   } else if (statement.stmt.type == StmtType::IF) {
     if (statement.stmt.statements.size() == 0) return FLAG_OK; // might cause bugs
     assert(statement.stmt.expressions.size() != 0);
@@ -185,10 +188,95 @@ int Evaluator::execute_statement(const Node &statement) {
   return FLAG_ERROR;
 }
 
-Value Evaluator::evaluate_expression(const NodeList &expression_tree, const bool get_ref) {
-  RpnStack rpn_stack;
-  rpn_stack.reserve(100);
-  flatten_tree(rpn_stack, expression_tree);
+// for (type name : arr|stream) statement
+// the loop walks the storage of the array directly, so there are no index expressions and bounds checks per element
+int Evaluator::execute_for_each(const Statement &statement) {
+  if (statement.statements.size() == 0) return FLAG_OK;
+  const Declaration &decl = statement.declaration[0].decl;
+  const Value iterable = evaluate_expression(statement.expressions[0]);
+  if (iterable.type != VarType::ARR && iterable.type != VarType::STREAM) {
+    const std::string &msg = "for each expects an array or a stream, found " + stringify(iterable);
+    throw_error(msg);
+  }
+  const VarType var_type = utils.var_lut.at(decl.var_type);
+  // the loop variable is declared once, every iteration only stores the next element in it
+  declarations++;
+  stack.erase(decl.id);
+  auto &var = (stack[decl.id] = std::make_shared<Variable>());
+  var->type = decl.var_type;
+  Value &element = var->val;
+  int flag = FLAG_OK;
+  nested_loops++;
+  if (iterable.type == VarType::ARR) {
+    const std::size_t size = iterable.array_size();
+    if (iterable.is_packed()) {
+      if (var_type != iterable.packed_type) {
+        const std::string &msg = "Cannot assign elements of " + iterable.array_type + " to a variable of type " + decl.var_type;
+        throw_error(msg);
+      }
+      element.type = var_type;
+    }
+    const std::int64_t *ints = iterable.packed_type == VarType::INT ? iterable.ints() : nullptr;
+    const double *floats = iterable.packed_type == VarType::FLOAT ? iterable.floats() : nullptr;
+    for (std::size_t i = 0; i < size; i++) {
+      if (ints != nullptr) {
+        element.number_value = ints[i];
+      } else if (floats != nullptr) {
+        element.float_value = floats[i];
+      } else if (iterable.packed_type == VarType::BOOL) {
+        element.boolean_value = iterable.array_storage->bools[iterable.array_offset + i];
+      } else {
+        element = iterable.array_ref(i);
+        if (element.type != var_type) {
+          const std::string &msg = "Cannot assign " + stringify(element) + " to a variable of type " + decl.var_type;
+          throw_error(msg);
+        }
+      }
+      flag = execute_statement(statement.statements[0]);
+      if (flag == FLAG_BREAK || flag == FLAG_RETURN) break;
+    }
+  } else {
+    Stream &stream = iterable.stream();
+    stream.bind(this, current_line);
+    while (stream.next(element)) {
+      if (element.type != var_type) {
+        const std::string &msg = "Cannot assign " + stringify(element) + " to a variable of type " + decl.var_type;
+        throw_error(msg);
+      }
+      flag = execute_statement(statement.statements[0]);
+      if (flag == FLAG_BREAK || flag == FLAG_RETURN) break;
+    }
+    stream.bind(nullptr, current_line);
+  }
+  nested_loops--;
+  return flag == FLAG_RETURN ? FLAG_RETURN : FLAG_OK;
+}
+
+// switch (expression) { case literal: statement(s) ... }
+// the case is found with one lookup in the table built by the parser, then the statements run until a break
+int Evaluator::execute_switch(const Statement &statement) {
+  const Value subject = evaluate_expression(statement.expressions[0]);
+  const SwitchTable &table = *statement.switch_table;
+  std::size_t start;
+  if (subject.type == VarType::INT && (!table.string_cases || table.cases == 0)) {
+    start = table.find(subject.number_value);
+  } else if (subject.type == VarType::STR && (table.string_cases || table.cases == 0)) {
+    start = table.find(subject.string_value.view());
+  } else {
+    const std::string &msg = "Cannot match " + stringify(subject) + " against " + (table.string_cases ? "str" : "int") + " case labels";
+    throw_error(msg);
+  }
+  int flag = FLAG_OK;
+  nested_switches++;
+  for (std::size_t i = start; i < statement.statements.size(); i++) {
+    flag = execute_statement(statement.statements[i]);
+    if (flag) break;
+  }
+  nested_switches--;
+  return flag == FLAG_BREAK ? FLAG_OK : flag;
+}
+
+SharedRpnElement Evaluator::reduce_rpn(RpnStack &rpn_stack) {
   // TODO: cache the result somehow
   SharedRpnStack res_stack;
   assert(rpn_stack.size() != 0);
@@ -268,7 +356,15 @@ Value Evaluator::evaluate_expression(const NodeList &expression_tree, const bool
       res_stack.emplace_back(SHARE_RPN(token));
     }
   }
-  Value &res_val = res_stack[0]->value;
+  return res_stack[0];
+}
+
+Value Evaluator::evaluate_expression(const NodeList &expression_tree, const bool get_ref) {
+  RpnStack rpn_stack;
+  rpn_stack.reserve(100);
+  flatten_tree(rpn_stack, expression_tree);
+  const SharedRpnElement result = reduce_rpn(rpn_stack);
+  Value &res_val = result->value;
   if (get_ref) {
     if (res_val.is_lvalue()) {
       std::shared_ptr<Variable> var = get_reference_by_name(res_val.reference_name);
@@ -294,17 +390,24 @@ Value Evaluator::evaluate_expression(const NodeList &expression_tree, const bool
   return res_val;
 }
 
+void Evaluator::execute_expression(const NodeList &expression_tree) {
+  // evaluates an expression for its side effects only, the result is never copied out
+  RpnStack rpn_stack;
+  rpn_stack.reserve(100);
+  flatten_tree(rpn_stack, expression_tree);
+  reduce_rpn(rpn_stack);
+}
+
+// short form for error messages, containers are only named instead of listing their contents
 std::string Evaluator::stringify(const Value &val) {
   if (val.heap_reference != -1) {
     return "reference to " + stringify(get_heap_value(val.heap_reference));
   } else if (val.type == VarType::STR) {
-    return val.string_value;
+    return std::string(val.string_value.view());
   } else if (val.type == VarType::BOOL) {
     return val.boolean_value ? "true" : "false";
-  } else if (val.type == VarType::FLOAT) {
-    return std::to_string(val.float_value);
-  } else if (val.type == VarType::INT) {
-    return std::to_string(val.number_value);
+  } else if (val.type == VarType::FLOAT || val.type == VarType::INT) {
+    return VM.stringify(val);
   } else if (val.type == VarType::FUNC) {
     return "function";
   } else if (val.type == VarType::CLASS) {
@@ -313,6 +416,22 @@ std::string Evaluator::stringify(const Value &val) {
     return "object";
   } else if (val.type == VarType::ARR) {
     return "array";
+  } else if (val.type == VarType::BUILDER) {
+    return "builder";
+  } else if (val.type == VarType::MAP) {
+    return "map";
+  } else if (val.type == VarType::SET) {
+    return "hashset";
+  } else if (val.type == VarType::OMAP) {
+    return "omap";
+  } else if (val.type == VarType::DEQUE) {
+    return "deque";
+  } else if (val.type == VarType::PQUEUE) {
+    return "pqueue";
+  } else if (val.type == VarType::STREAM) {
+    return "stream";
+  } else if (val.type == VarType::REGEX) {
+    return "regex";
   } else if (val.type == VarType::VOID) {
     return "void";
   } else if (val.type == VarType::UNKNOWN) {
@@ -393,7 +512,7 @@ RpnElement Evaluator::perform_addition(const RpnElement &x, const RpnElement &y)
     if (y_val.type == utils.var_lut.at(x_val.array_type)) {
       // append to array
       Value x_val_cpy = x_val;
-      x_val_cpy.array_values.push_back(y_val);
+      x_val_cpy.array_push(y_val);
       return {x_val_cpy};
     } else {
       throw_error("Cannot append " + stringify(y_val) + " to an array of " + x_val.array_type + "s");
@@ -402,14 +521,16 @@ RpnElement Evaluator::perform_addition(const RpnElement &x, const RpnElement &y)
     if (x_val.type == utils.var_lut.at(y_val.array_type)) {
       // prepend to array
       Value y_val_cpy = y_val;
-      y_val_cpy.array_values.insert(y_val.array_values.begin(), x_val);
+      y_val_cpy.array_insert(0, x_val);
       return {y_val_cpy};
     } else {
       throw_error("Cannot prepend " + stringify(x_val) + " to an array of " + y_val.array_type + "s");
     }
   } else if (x_val.type == VarType::STR || y_val.type == VarType::STR) {
     val.type = VarType::STR;
-    val.string_value = stringify(x_val) + stringify(y_val);
+    std::string &str = val.string_value.mut();
+    VM.stringify(x_val, str);
+    VM.stringify(y_val, str);
     return {val};
   } else if (x_val.type == VarType::INT && y_val.type == VarType::INT) {
     val.type = VarType::INT;
@@ -436,11 +557,11 @@ RpnElement Evaluator::perform_subtraction(const RpnElement &x, const RpnElement
   } else if (x_val.type == VarType::ARR && y_val.type == VarType::INT) {
     // remove from array
     Value x_val_cpy = x_val;
-    if (y_val.number_value < 0 || y_val.number_value >= x_val_cpy.array_values.size()) {
+    if (y_val.number_value < 0 || (std::size_t)y_val.number_value >= x_val_cpy.array_size()) {
       const std::string &msg = "cannot remove index [" + std::to_string(y_val.number_value) + "] (out of range)";
       throw_error(msg);
     }
-    x_val_cpy.array_values.erase(x_val_cpy.array_values.begin() + y_val.number_value);
+    x_val_cpy.array_erase(y_val.number_value);
     return {x_val_cpy};
   } else if (x_val.type == VarType::FLOAT || y_val.type == VarType::FLOAT) {
     val.type = VarType::FLOAT;
@@ -536,7 +657,7 @@ RpnElement Evaluator::bitwise_xor(const RpnElement &x, const RpnElement &y) {
     // concat arrays
     if (x_val.array_type == y_val.array_type) {
       Value x_val_cpy = x_val;
-      x_val_cpy.array_values.insert(x_val.array_values.end(), y_val.array_values.begin(), y_val.array_values.end());
+      x_val_cpy.array_append(y_val);
       return {x_val_cpy};
     } else {
       const std::string &msg = "Cannot concatenate arrays of type " + x_val.array_type + " and " + y_val.array_type;
@@ -610,11 +731,43 @@ RpnElement Evaluator::assign(RpnElement &x, const RpnElement &y) {
 }
 
 RpnElement Evaluator::plus_assign(RpnElement &x, const RpnElement &y) {
+  Value *target = get_mutable_lvalue(x, VarType::ARR);
+  if (target != nullptr) {
+    // append in place
+    const Value &y_val = get_value(y);
+    if (y_val.type != utils.var_lut.at(target->array_type)) {
+      throw_error("Cannot append " + stringify(y_val) + " to an array of " + target->array_type + "s");
+    }
+    target->array_push(y_val);
+    return x;
+  }
+  target = get_mutable_lvalue(x, VarType::STR);
+  if (target != nullptr && get_value(y).type != VarType::ARR) {
+    // append to the string in place
+    const Value &y_val = get_value(y);
+    std::string &str = target->string_value.mut();
+    VM.stringify(y_val, str);
+    return x;
+  }
   const RpnElement &rvalue = perform_addition(x, y);
   return assign(x, rvalue);
 }
 
 RpnElement Evaluator::minus_assign(RpnElement &x, const RpnElement &y) {
+  Value *target = get_mutable_lvalue(x, VarType::ARR);
+  if (target != nullptr) {
+    // remove in place
+    const Value &y_val = get_value(y);
+    if (y_val.type != VarType::INT) {
+      throw_error("Cannot perform subtraction on " + stringify(*target) + " and " + stringify(y_val));
+    }
+    if (y_val.number_value < 0 || (std::size_t)y_val.number_value >= target->array_size()) {
+      const std::string &msg = "cannot remove index [" + std::to_string(y_val.number_value) + "] (out of range)";
+      throw_error(msg);
+    }
+    target->array_erase(y_val.number_value);
+    return x;
+  }
   const RpnElement &rvalue = perform_subtraction(x, y);
   return assign(x, rvalue);
 }
@@ -655,6 +808,20 @@ RpnElement Evaluator::or_assign(RpnElement &x, const RpnElement &y) {
 }
 
 RpnElement Evaluator::xor_assign(RpnElement &x, const RpnElement &y) {
+  Value *target = get_mutable_lvalue(x, VarType::ARR);
+  if (target != nullptr) {
+    // concat in place
+    const Value &y_val = get_value(y);
+    if (y_val.type != VarType::ARR) {
+      throw_error("Cannot perform bitwise xor on " + stringify(*target) + " and " + stringify(y_val));
+    }
+    if (target->array_type != y_val.array_type) {
+      const std::string &msg = "Cannot concatenate arrays of type " + target->array_type + " and " + y_val.array_type;
+      throw_error(msg);
+    }
+    target->array_append(y_val);
+    return x;
+  }
   const RpnElement &rvalue = bitwise_xor(x, y);
   return assign(x, rvalue);
 }
@@ -683,7 +850,7 @@ RpnElement Evaluator::access_member(RpnElement &x, const RpnElement &y) {
 
 RpnElement Evaluator::access_index(RpnElement &arr, const RpnElement &idx) {
   Value &array = get_mut_value(arr);
-  if (array.type != VarType::ARR) {
+  if (array.type != VarType::ARR && array.type != VarType::STR) {
     const std::string &msg = stringify(array) + " is not an array";
     throw_error(msg);
   }
@@ -692,12 +859,18 @@ RpnElement Evaluator::access_index(RpnElement &arr, const RpnElement &idx) {
     const std::string &msg = "index expected to be an int, but " + stringify(index) + " found";
     throw_error(msg);
   }
-  if (index.number_value < 0 || index.number_value >= array.array_values.size()) {
+  const std::size_t size = array.type == VarType::STR ? array.string_value.size() : array.array_size();
+  if (index.number_value < 0 || (std::size_t)index.number_value >= size) {
     const std::string &msg = "index [" + std::to_string(index.number_value) + "] out of range";
     throw_error(msg);
   }
-  Value &res = array.array_values[index.number_value];
-  return {res};
+  if (array.type == VarType::STR) {
+    // a one character view into the string
+    Value character(VarType::STR);
+    character.string_value = SharedString(array.string_value, index.number_value, 1);
+    return {character};
+  }
+  return {array.array_at(index.number_value)};
 }
 
 RpnElement Evaluator::compare_eq(const RpnElement &x, const RpnElement &y) {
@@ -769,6 +942,7 @@ RpnElement Evaluator::compare_lt_eq(const RpnElement &x, const RpnElement &y) {
 }
 
 void Evaluator::register_class(const ClassStatement &_class) {
+  declarations++;
   const std::shared_ptr<Variable> v = get_reference_by_name(_class.class_name);
   if (v != nullptr) {
     stack.erase(_class.class_name);
@@ -781,6 +955,7 @@ void Evaluator::register_class(const ClassStatement &_class) {
 }
 
 void Evaluator::declare_variable(const Node &declaration) {
+  declarations++;
   const Declaration &decl = declaration.decl;
   const Value &var_val = evaluate_expression(decl.var_expr, decl.reference);
   const Utils::VarType &var_type = utils.var_lut.at(decl.var_type);
@@ -880,7 +1055,11 @@ RpnElement Evaluator::execute_function(RpnElement &fn, const RpnElement &call) {
       call_args.push_back(evaluate_expression(node_list, needs_ref));
     }
     VM.trace.push(fn.value.reference_name, current_line, current_source);
+    // natives that take a function call it through the evaluator they were called from
+    Evaluator *caller = VM.evaluator;
+    VM.evaluator = this;
     const Value &return_val = global_it->second->execute(call_args, current_line, VM);
+    VM.evaluator = caller;
     VM.trace.pop();
     return {return_val};
   }
@@ -900,12 +1079,21 @@ RpnElement Evaluator::execute_function(RpnElement &fn, const RpnElement &call) {
     }
     Value str = fn_value;
     if (args == 0) return {str};
-    int argn = 1;
+    std::vector<std::string> arg_strings(args);
+    std::size_t arg_index = 0;
     for (const auto &arg : call.op.func_call.arguments) {
-      Value arg_val = evaluate_expression(arg);
-      std::string find = "@" + std::to_string(argn);
-      str.string_value = std::regex_replace(str.string_value, std::regex(find), VM.stringify(arg_val));
-      argn++;
+      if (arg.size() == 0) continue;
+      VM.stringify(evaluate_expression(arg), arg_strings[arg_index++]);
+    }
+    if (str.string_value.interned()) {
+      const std::string *address = str.string_value.address();
+      auto it = VM.templates.find(address);
+      if (it == VM.templates.end()) {
+        it = VM.templates.emplace(address, StringTemplate(*address)).first;
+      }
+      str.string_value = it->second.format(arg_strings);
+    } else {
+      str.string_value = StringTemplate(str.string_value.view()).format(arg_strings);
     }
     return {str};
   }
@@ -929,44 +1117,67 @@ RpnElement Evaluator::execute_function(RpnElement &fn, const RpnElement &call) {
     throw_error(msg);
   }
 
-  Evaluator func_evaluator(fn_value.func.instructions[0], VM, utils);
-  func_evaluator.stack.reserve(100);
-  func_evaluator.inside_func = true;
-  func_evaluator.returns_ref = fn_value.func.ret_ref;
-
+  std::vector<Value> args;
+  args.reserve(args_counter);
   if (fn_value.func.params.size() != 0) {
     int i = 0;
     for (const auto &node_list : call.op.func_call.arguments) {
-      const FuncParam &fn_param = fn_value.func.params[i];
-      const Value &arg_val = evaluate_expression(node_list, fn_param.is_ref);
-      if (fn_param.is_ref && arg_val.heap_reference == -1) {
-        std::string num = std::to_string(i + 1);
-        const std::string &msg = "Argument " + num + " expected to be a reference, but value given";
-        throw_error(msg);
-      }
-      VarType arg_type = arg_val.type;
-      const auto &expected_type = utils.var_lut.at(fn_param.type_name);
-      if (arg_type != expected_type) {
-        Value real_val = arg_val;
-        if (arg_val.heap_reference != -1) {
-          real_val = get_heap_value(arg_val.heap_reference);
-          arg_type = real_val.type;
-        }
-        if (arg_type != expected_type) {
-          std::string num = std::to_string(i + 1);
-          const std::string &msg = "Argument " + num + " expected to be " + fn_param.type_name + ", but " + stringify(real_val) + " given";
-          throw_error(msg);
-        }
-      }
-      auto &var = (func_evaluator.stack[fn_param.param_name] = std::make_shared<Variable>());
-      var->type = fn_param.type_name;
-      var->val = arg_val;
+      args.push_back(evaluate_expression(node_list, fn_value.func.params[i].is_ref));
+      check_argument(fn_value, i, args.back());
       i++;
     }
   }
-  if (fn.value.is_lvalue()) {
+  const std::shared_ptr<Variable> *self = fn.value.is_lvalue() ? &stack[fn.value.reference_name] : nullptr;
+  const Symbol &fn_name = fn.value.is_lvalue() ? fn.value.reference_name : fn_value.func_name;
+  return {invoke(fn_value, args, fn_name, self)};
+}
+
+void Evaluator::check_argument(const Value &fn_value, std::size_t index, const Value &arg_val) {
+  const FuncParam &fn_param = fn_value.func.params[index];
+  if (fn_param.is_ref && arg_val.heap_reference == -1) {
+    std::string num = std::to_string(index + 1);
+    const std::string &msg = "Argument " + num + " expected to be a reference, but value given";
+    throw_error(msg);
+  }
+  VarType arg_type = arg_val.type;
+  const auto &expected_type = utils.var_lut.at(fn_param.type_name);
+  if (arg_type != expected_type) {
+    Value real_val = arg_val;
+    if (arg_val.heap_reference != -1) {
+      real_val = get_heap_value(arg_val.heap_reference);
+      arg_type = real_val.type;
+    }
+    if (arg_type != expected_type) {
+      std::string num = std::to_string(index + 1);
+      const std::string &msg = "Argument " + num + " expected to be " + fn_param.type_name + ", but " + stringify(real_val) + " given";
+      throw_error(msg);
+    }
+  }
+}
+
+// runs the body of a function with checked arguments, self is the variable holding the function if it was called by name
+Value Evaluator::invoke(const Value &fn_value, std::vector<Value> &args, const Symbol &fn_name, const std::shared_ptr<Variable> *self) {
+  Evaluator func_evaluator(fn_value.func.instructions[0], VM, utils);
+  func_evaluator.stack.reserve(100);
+  for (std::size_t i = 0; i < args.size(); i++) {
+    const FuncParam &fn_param = fn_value.func.params[i];
+    auto &var = (func_evaluator.stack[fn_param.param_name] = std::make_shared<Variable>());
+    var->type = fn_param.type_name;
+    var->val = std::move(args[i]);
+  }
+  prepare_callee(func_evaluator, fn_value, fn_name, self);
+  VM.trace.push(fn_name, current_line, current_source);
+  func_evaluator.start();
+  return function_result(fn_value, func_evaluator);
+}
+
+// everything on the callee's stack except for the parameters
+void Evaluator::prepare_callee(Evaluator &func_evaluator, const Value &fn_value, const Symbol &fn_name, const std::shared_ptr<Variable> *self) {
+  func_evaluator.inside_func = true;
+  func_evaluator.returns_ref = fn_value.func.ret_ref;
+  if (self != nullptr) {
     // push itself onto the new callstack
-    func_evaluator.stack[fn.value.reference_name] = stack[fn.value.reference_name];
+    func_evaluator.stack[fn_name] = *self;
   }
   if (fn_value.this_ref != -1) {
     // push "this" onto the stack
@@ -978,10 +1189,10 @@ RpnElement Evaluator::execute_function(RpnElement &fn, const RpnElement &call) {
     // copy the current callstack to the new callstack
     for (const auto &pair : stack) {
       if (pair.first == "this") continue;
-      if (fn.value.is_lvalue() && pair.first == fn.value.reference_name) continue;
+      if (self != nullptr && pair.first == fn_name.str()) continue;
       bool contains = false;
       for (const auto &p : fn_value.func.params) {
-        if (p.param_name == pair.first) {
+        if (p.param_name.str() == pair.first) {
           contains = true;
           break;
         }
@@ -990,9 +1201,10 @@ RpnElement Evaluator::execute_function(RpnElement &fn, const RpnElement &call) {
       func_evaluator.stack[pair.first] = stack[pair.first];
     }
   }
-  const std::string &fn_name = fn.value.is_lvalue() ? fn.value.reference_name : fn_value.func_name;
-  VM.trace.push(fn_name, current_line, current_source);
-  func_evaluator.start();
+}
+
+// checks the value returned by a function that ran and pops it from the stack trace
+Value Evaluator::function_result(const Value &fn_value, Evaluator &func_evaluator) {
   if (fn_value.func.ret_ref) {
     if (func_evaluator.return_value.heap_reference == -1) {
       const std::string &msg = "function returns a reference, but " + stringify(func_evaluator.return_value) + " was returned";
@@ -1006,7 +1218,7 @@ RpnElement Evaluator::execute_function(RpnElement &fn, const RpnElement &call) {
       return {};
     }
     VM.trace.pop();
-    return {func_evaluator.return_value};
+    return func_evaluator.return_value;
   } else {
     if (func_evaluator.return_value.type != utils.var_lut.at(fn_value.func.ret_type)) {
       const std::string &msg = "function return type is " + fn_value.func.ret_type + ", but " + stringify(func_evaluator.return_value) + " was returned";
@@ -1014,9 +1226,8 @@ RpnElement Evaluator::execute_function(RpnElement &fn, const RpnElement &call) {
       return {};
     }
     VM.trace.pop();
-    return {func_evaluator.return_value};
+    return func_evaluator.return_value;
   }
-  return {};
 }
 
 void Evaluator::node_to_element(const Node &node, RpnStack &container) {
@@ -1081,12 +1292,20 @@ void Evaluator::node_to_element(const Node &node, RpnStack &container) {
         initial_size.number_value = elemenets_count;
       }
     }
-    val.type = VarType::ARR;
-    val.array_type = node.expr.array_type;
+    val.set_array_type(node.expr.array_type, node.expr.array_holds_refs);
     if (initial_size.number_value != 0) {
-      val.array_values.resize(initial_size.number_value);
+      ArrayStorage &storage = val.mut_array();
+      if (val.packed_type == VarType::INT) {
+        storage.ints.resize(initial_size.number_value);
+      } else if (val.packed_type == VarType::FLOAT) {
+        storage.floats.resize(initial_size.number_value);
+      } else if (val.packed_type == VarType::BOOL) {
+        storage.bools.resize(initial_size.number_value);
+      } else {
+        storage.values.resize(initial_size.number_value);
+        for (auto &v : storage.values) v.type = arr_type;
+      }
     }
-    for (auto &v : val.array_values) v.type = arr_type;
     int i = 0;
     for (const auto &node_list : node.expr.array_expressions) {
       if (node_list.size() == 0) {
@@ -1096,8 +1315,7 @@ void Evaluator::node_to_element(const Node &node, RpnStack &container) {
           throw_error("Empty array element");
         }
       }
-      Value &curr_el = val.array_values[i];
-      curr_el = evaluate_expression(node_list, node.expr.array_holds_refs);
+      const Value &curr_el = evaluate_expression(node_list, node.expr.array_holds_refs);
       if (node.expr.array_holds_refs && curr_el.heap_reference == -1) {
         throw_error("Array holds references, but null or value given");
       }
@@ -1110,6 +1328,7 @@ void Evaluator::node_to_element(const Node &node, RpnStack &container) {
         const std::string &msg = "Cannot add " + stringify(curr_el) + " to an array of " + node.expr.array_type + "s";
         throw_error(msg);
       }
+      val.array_set(i, curr_el);
       i++;
     }
     container.emplace_back(val);
@@ -1127,7 +1346,7 @@ std::shared_ptr<Variable> Evaluator::get_reference_by_name(const std::string &na
   return el->second;
 }
 
-void Evaluator::set_member(const std::vector<std::string> &members, const NodeList &expression) {
+void Evaluator::set_member(const std::vector<Symbol> &members, const NodeList &expression) {
   assert(members.size() > 1);
   const std::string &base = members[0];
   std::shared_ptr<Variable> var = get_reference_by_name(base);
@@ -1175,30 +1394,45 @@ void Evaluator::set_index(const Statement &stmt) {
     const std::string &msg = "'" + stmt.obj_members[0] + "' is not defined";
     throw_error(msg);
   }
-  Value *val = arr->val.heap_reference != -1 ? &get_heap_value(arr->val.heap_reference) : &arr->val;
-  std::vector<Value *> references;
-  references.reserve(stmt.indexes.size() + 1);
-  references.push_back(val);
+  // the elements are looked up for writing only after the indexes and the rvalue are evaluated,
+  // so that neither can move them or end up sharing the storage that's written to
+  std::vector<std::int64_t> positions;
+  positions.reserve(stmt.indexes.size());
   for (const auto &index : stmt.indexes) {
-    Value *temp = references.back();
-    temp = temp->heap_reference != -1 ? &get_heap_value(temp->heap_reference) : temp;
-    if (temp->type != VarType::ARR) {
-      throw_error(stringify(*temp) + "is not an array");
-    }
     const Value index_val = evaluate_expression(index.expr.index);
     if (index_val.type != VarType::INT) {
       const std::string &msg = "Cannot access array with " + stringify(index_val);
       throw_error(msg);
     }
-    if (index_val.number_value < 0 || index_val.number_value >= temp->array_values.size()) {
-      const std::string &msg = "Index [" + std::to_string(index_val.number_value) + "] out of range";
+    positions.push_back(index_val.number_value);
+  }
+  const Value rvalue = evaluate_expression(stmt.expressions[0]);
+  Value *temp = &arr->val;
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    temp = temp->heap_reference != -1 ? &get_heap_value(temp->heap_reference) : temp;
+    if (temp->type != VarType::ARR) {
+      throw_error(stringify(*temp) + "is not an array");
+    }
+    const std::int64_t index = positions[i];
+    if (index < 0 || (std::size_t)index >= temp->array_size()) {
+      const std::string &msg = "Index [" + std::to_string(index) + "] out of range";
       throw_error(msg);
     }
-    references.push_back(&temp->array_values[index_val.number_value]);
+    if (temp->is_packed()) {
+      // packed elements have no Value to point to, write straight into the buffer
+      if (i != positions.size() - 1) {
+        throw_error(stringify(temp->array_at(index)) + "is not an array");
+      }
+      if (temp->packed_type != rvalue.type) {
+        const std::string &msg = "Cannot assign " + stringify(rvalue) + ", incorrect type";
+        throw_error(msg);
+      }
+      temp->array_set(index, rvalue);
+      return;
+    }
+    temp = &temp->array_mut(index);
   }
-  const Value &rvalue = evaluate_expression(stmt.expressions[0]);
-  Value *fin = references.back();
-  fin = fin->heap_reference != -1 ? &get_heap_value(fin->heap_reference) : fin;
+  Value *fin = temp->heap_reference != -1 ? &get_heap_value(temp->heap_reference) : temp;
   if (fin->type != rvalue.type) {
     const std::string &msg = "Cannot assign " + stringify(rvalue) + ", incorrect type";
     throw_error(msg);
@@ -1248,6 +1482,19 @@ Value &Evaluator::get_mut_value(RpnElement &el) {
   }
 }
 
+Value *Evaluator::get_mutable_lvalue(RpnElement &el, VarType type) {
+  // the array or string a variable holds, so that compound assignments can modify it without copying
+  if (!el.value.is_lvalue() || el.value.member_name.size() != 0) {
+    return nullptr;
+  }
+  std::shared_ptr<Variable> var = get_reference_by_name(el.value.reference_name);
+  if (var == nullptr || var->constant) {
+    return nullptr;
+  }
+  Value *val = var->val.heap_reference > -1 ? &get_heap_value(var->val.heap_reference) : &var->val;
+  return val->type == type ? val : nullptr;
+}
+
 Value &Evaluator::get_heap_value(std::int64_t ref) {
   if (ref < 0 || ref >= VM.heap.chunks.size()) {
     throw_error("dereferencing a value that is not on the heap");
@@ -1268,4 +1515,55 @@ void Evaluator::flatten_tree(RpnStack &res, const NodeList &expression_tree) {
       node_to_element(node, res);
     }
   }
-}
\ No newline at end of file
+}
+FunctionCaller::FunctionCaller(Evaluator &_caller, const Value &_fn_value) : caller(_caller), fn_value(_fn_value) {
+  if (fn_value.type != VarType::FUNC) {
+    const std::string &msg = caller.stringify(fn_value) + " is not a function";
+    caller.throw_error(msg);
+  }
+  for (const auto &param : fn_value.func.params) {
+    param_types.push_back(caller.utils.var_lut.at(param.type_name));
+  }
+}
+
+void FunctionCaller::prepare(void) {
+  callee = std::make_unique<Evaluator>(fn_value.func.instructions[0], caller.VM, caller.utils);
+  callee->stack.reserve(100);
+  params.clear();
+  for (const auto &fn_param : fn_value.func.params) {
+    auto &var = (callee->stack[fn_param.param_name] = std::make_shared<Variable>());
+    var->type = fn_param.type_name;
+    params.push_back(var.get());
+  }
+  caller.prepare_callee(*callee, fn_value, fn_value.func_name, nullptr);
+  callee->declarations = 0;
+}
+
+Value FunctionCaller::call(const Value *args[]) {
+  if (fn_value.func.instructions.size() == 0) return {};
+  for (std::size_t i = 0; i < param_types.size(); i++) {
+    // the full check also handles references and reports the error
+    if (args[i]->type != param_types[i] || args[i]->heap_reference != -1 || fn_value.func.params[i].is_ref) {
+      caller.check_argument(fn_value, i, *args[i]);
+    }
+  }
+  // a recursive call can't reuse the stack of the call that is still running
+  if (running) {
+    FunctionCaller fresh(caller, fn_value);
+    return fresh.call(args);
+  }
+  // a declaration could have shadowed a parameter or a captured variable, the next call needs a clean stack
+  if (callee == nullptr || callee->declarations != 0) {
+    prepare();
+  }
+  for (std::size_t i = 0; i < params.size(); i++) {
+    params[i]->val = *args[i];
+  }
+  callee->return_value = Value();
+  callee->nested_loops = 0;
+  caller.VM.trace.push(fn_value.func_name, caller.current_line, caller.current_source);
+  running = true;
+  callee->start();
+  running = false;
+  return caller.function_result(fn_value, *callee);
+}
@@ -8,6 +8,7 @@
 
 #include <cstdint>
 #include <vector>
+#include <memory>
 
 class Operator {
   public:
@@ -38,10 +39,15 @@ class RpnElement {
 };
 
 typedef std::vector<RpnElement> RpnStack;
+typedef std::shared_ptr<RpnElement> SharedRpnElement;
+typedef std::vector<SharedRpnElement> SharedRpnStack;
 
 class Evaluator {
+  friend class FunctionCaller;
   private:
     NativeFunction *native_bind = nullptr;
+    // counts the variables and classes declared on this stack
+    std::uint64_t declarations = 0;
   public:
     CVM &VM;
     const Node &AST;
@@ -56,23 +62,28 @@ class Evaluator {
     bool inside_func = false;
     bool returns_ref = false;
     int nested_loops = 0;
+    int nested_switches = 0;
     std::uint64_t current_line = 0;
     std::string *current_source = nullptr;
     void throw_error(const std::string &cause);
     int execute_statement(const Node &statement);
+    int execute_for_each(const Statement &statement);
+    int execute_switch(const Statement &statement);
     Value evaluate_expression(const NodeList &expression_tree, const bool get_ref = false);
+    void execute_expression(const NodeList &expression_tree);
     void declare_variable(const Node &declaration);
     void register_class(const ClassStatement &_class);
     void flatten_tree(RpnStack &res, const NodeList &expression_tree);
     void node_to_element(const Node &node, RpnStack &container);
     std::shared_ptr<Variable> get_reference_by_name(const std::string &name);
-    Value reduce_rpn(RpnStack &stack);
+    SharedRpnElement reduce_rpn(RpnStack &rpn_stack);
     std::string stringify(const Value &val);
     inline double to_double(const Value &val);
     const Value &get_value(const RpnElement &el);
     Value &get_mut_value(RpnElement &el);
     Value &get_heap_value(std::int64_t ref);
-    void set_member(const std::vector<std::string> &members, const NodeList &expression);
+    Value *get_mutable_lvalue(RpnElement &el, Utils::VarType type);
+    void set_member(const std::vector<Symbol> &members, const NodeList &expression);
     void set_index(const Statement &stmt);
 
     // Unary
@@ -117,6 +128,10 @@ class Evaluator {
     RpnElement compare_lt_eq(const RpnElement &x, const RpnElement &y);
     // functions
     RpnElement execute_function(RpnElement &fn, const RpnElement &call);
+    void check_argument(const Value &fn_value, std::size_t index, const Value &arg_val);
+    Value invoke(const Value &fn_value, std::vector<Value> &args, const Symbol &fn_name, const std::shared_ptr<Variable> *self);
+    void prepare_callee(Evaluator &func_evaluator, const Value &fn_value, const Symbol &fn_name, const std::shared_ptr<Variable> *self);
+    Value function_result(const Value &fn_value, Evaluator &func_evaluator);
     // misc
     RpnElement access_member(RpnElement &x, const RpnElement &y);
     RpnElement access_index(RpnElement &arr, const RpnElement &idx);
@@ -125,4 +140,24 @@ class Evaluator {
     Value return_value;
 };
 
+// calls one function value many times from a native, like map() or filter() on every element of an array
+// the callee's stack is set up once and reused for the following calls, unless the function body declared something on it
+class FunctionCaller {
+  private:
+    Evaluator &caller;
+    const Value fn_value;
+    std::unique_ptr<Evaluator> callee;
+    std::vector<Variable *> params;
+    std::vector<Utils::VarType> param_types;
+    bool running = false;
+    void prepare(void);
+  public:
+    FunctionCaller(Evaluator &_caller, const Value &_fn_value);
+    std::size_t arity(void) const { return param_types.size(); }
+    // true while the function is executing
+    bool busy(void) const { return running; }
+    // the number of arguments has to match arity()
+    Value call(const Value *args[]);
+};
+
 #endif // __EVALUATOR_
\ No newline at end of file
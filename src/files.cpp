@@ -0,0 +1,372 @@
+#include "files.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) return nullptr;
+  struct stat info;
+  if (fstat(fd, &info) == -1 || !S_ISREG(info.st_mode)) {
+    close(fd);
+    return nullptr;
+  }
+  // mmap refuses empty mappings
+  if (info.st_size == 0) {
+    close(fd);
+    return std::make_shared<MappedFile>(nullptr, 0);
+  }
+  void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping keeps the file open
+  close(fd);
+  if (data == MAP_FAILED) return nullptr;
+  return std::make_shared<MappedFile>(data, info.st_size);
+}
+
+MappedFile::~MappedFile() {
+  if (data != nullptr) munmap(data, size);
+}
+
+LineReader::LineReader(const std::string &path) : fd(::open(path.c_str(), O_RDONLY)) {
+  if (fd == -1) return;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  chunk = std::make_shared<std::string>(CHUNK_SIZE, '\0');
+}
+
+LineReader::~LineReader() {
+  if (fd != -1) close(fd);
+}
+
+// moves the unfinished line to the front and reads after it
+bool LineReader::fill(void) {
+  const std::size_t left = filled - position;
+  std::size_t capacity = chunk->size();
+  // a line longer than the chunk
+  if (left == capacity) capacity *= 2;
+  if (chunk.use_count() > 1 || capacity != chunk->size()) {
+    // lines handed out earlier still point into the old chunk
+    auto next_chunk = std::make_shared<std::string>(capacity, '\0');
+    std::memcpy(next_chunk->data(), chunk->data() + position, left);
+    chunk = next_chunk;
+  } else {
+    std::memmove(chunk->data(), chunk->data() + position, left);
+  }
+  position = 0;
+  filled = left;
+  ssize_t count;
+  do {
+    count = read(fd, chunk->data() + filled, chunk->size() - filled);
+  } while (count == -1 && errno == EINTR);
+  if (count <= 0) {
+    eof = true;
+    return false;
+  }
+  filled += count;
+  return true;
+}
+
+bool LineReader::next(std::string_view &line, std::shared_ptr<const void> &owner) {
+  if (fd == -1) return false;
+  std::size_t searched = position;
+  while (true) {
+    const char *start = chunk->data() + position;
+    const void *newline = std::memchr(chunk->data() + searched, '\n', filled - searched);
+    if (newline != nullptr) {
+      const std::size_t length = (const char *)newline - start;
+      line = std::string_view(start, length);
+      owner = chunk;
+      position += length + 1;
+      return true;
+    }
+    if (eof) break;
+    // the part that was already read has no newline
+    const std::size_t unfinished = filled - position;
+    if (!fill()) break;
+    searched = unfinished;
+  }
+  // the last line doesn't end with a newline
+  if (position == filled) return false;
+  line = std::string_view(chunk->data() + position, filled - position);
+  owner = chunk;
+  position = filled;
+  return true;
+}
+
+std::unique_ptr<FileHandle> FileHandle::open(const std::string &path, std::string_view mode, std::string &error) {
+  int flags;
+  if (mode == "r") flags = O_RDONLY;
+  else if (mode == "w") flags = O_WRONLY | O_CREAT | O_TRUNC;
+  else if (mode == "a") flags = O_WRONLY | O_CREAT | O_APPEND;
+  else if (mode == "r+") flags = O_RDWR;
+  else if (mode == "w+") flags = O_RDWR | O_CREAT | O_TRUNC;
+  else if (mode == "a+") flags = O_RDWR | O_CREAT | O_APPEND;
+  else {
+    error = "invalid mode " + std::string(mode);
+    return nullptr;
+  }
+  int fd = ::open(path.c_str(), flags, 0666);
+  if (fd == -1) {
+    error = "couldn't open " + path + ": " + std::strerror(errno);
+    return nullptr;
+  }
+  return std::make_unique<FileHandle>(fd, mode[0] == 'r' || mode.size() == 2, mode[0] != 'r' || mode.size() == 2);
+}
+
+FileHandle::~FileHandle() {
+  if (fd != -1) close();
+}
+
+bool FileHandle::write_all(const char *first, std::size_t first_size, const char *second, std::size_t second_size) {
+  struct iovec parts[2] = {{(void *)first, first_size}, {(void *)second, second_size}};
+  int index = 0;
+  while (index < 2) {
+    ssize_t written = writev(fd, parts + index, 2 - index);
+    if (written == -1) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    // skip what was written completely, a partial write continues in the middle of a part
+    while (index < 2 && (std::size_t)written >= parts[index].iov_len) {
+      written -= parts[index].iov_len;
+      index++;
+    }
+    if (index < 2) {
+      parts[index].iov_base = (char *)parts[index].iov_base + written;
+      parts[index].iov_len -= written;
+    }
+  }
+  return true;
+}
+
+bool FileHandle::drop_read_buffer(void) {
+  const std::size_t unread = read_end - read_position;
+  read_position = read_end = 0;
+  return unread == 0 || lseek(fd, -(off_t)unread, SEEK_CUR) != -1;
+}
+
+bool FileHandle::write(std::string_view data) {
+  if (!drop_read_buffer()) return false;
+  if (pending + data.size() <= BUFFER_SIZE) {
+    if (write_buffer.empty()) write_buffer.resize(BUFFER_SIZE);
+    std::memcpy(write_buffer.data() + pending, data.data(), data.size());
+    pending += data.size();
+    return true;
+  }
+  const bool written = write_all(write_buffer.data(), pending, data.data(), data.size());
+  pending = 0;
+  return written;
+}
+
+bool FileHandle::flush(void) {
+  if (pending == 0) return true;
+  const bool written = write_all(write_buffer.data(), pending, nullptr, 0);
+  pending = 0;
+  return written;
+}
+
+static ssize_t read_some(int fd, char *to, std::size_t count) {
+  ssize_t got;
+  do {
+    got = ::read(fd, to, count);
+  } while (got == -1 && errno == EINTR);
+  return got;
+}
+
+bool FileHandle::read(std::size_t count, std::string &out) {
+  if (!flush()) return false;
+  while (count > 0) {
+    if (read_position == read_end) {
+      // large reads go straight into the string
+      if (count >= BUFFER_SIZE) {
+        const std::size_t size = out.size();
+        out.resize(size + count);
+        ssize_t got = read_some(fd, out.data() + size, count);
+        out.resize(size + std::max<ssize_t>(got, 0));
+        if (got <= 0) return got == 0;
+        count -= got;
+        continue;
+      }
+      if (read_buffer.empty()) read_buffer.resize(BUFFER_SIZE);
+      ssize_t got = read_some(fd, read_buffer.data(), BUFFER_SIZE);
+      if (got <= 0) return got == 0;
+      read_position = 0;
+      read_end = got;
+    }
+    const std::size_t taken = std::min(count, read_end - read_position);
+    out.append(read_buffer.data() + read_position, taken);
+    read_position += taken;
+    count -= taken;
+  }
+  return true;
+}
+
+std::int64_t FileHandle::seek(std::int64_t offset, int whence) {
+  if (!flush() || !drop_read_buffer()) return -1;
+  return lseek(fd, offset, whence);
+}
+
+bool FileHandle::close(void) {
+  const bool flushed = flush();
+  const bool closed = ::close(fd) == 0;
+  fd = -1;
+  return flushed && closed;
+}
+
+// std::exit (exit() and runtime errors) doesn't destroy the interpreter, the tables are closed from atexit instead
+static std::vector<FileTable *> *live_tables = nullptr;
+
+static void close_live_tables(void) {
+  for (FileTable *table : *live_tables) {
+    table->close_all();
+  }
+}
+
+FileTable::FileTable(void) {
+  if (live_tables == nullptr) {
+    live_tables = new std::vector<FileTable *>();
+    std::atexit(close_live_tables);
+  }
+  live_tables->push_back(this);
+}
+
+FileTable::~FileTable() {
+  close_all();
+  live_tables->erase(std::find(live_tables->begin(), live_tables->end(), this));
+}
+
+std::int64_t FileTable::add(std::unique_ptr<FileHandle> file) {
+  if (free_handles.empty()) {
+    handles.push_back(std::move(file));
+    return handles.size() - 1;
+  }
+  const std::int64_t handle = free_handles.back();
+  free_handles.pop_back();
+  handles[handle] = std::move(file);
+  return handle;
+}
+
+FileHandle *FileTable::get(std::int64_t handle) {
+  if (handle < 0 || (std::size_t)handle >= handles.size()) return nullptr;
+  return handles[handle].get();
+}
+
+bool FileTable::close(std::int64_t handle) {
+  const bool closed = handles[handle]->close();
+  handles[handle].reset();
+  free_handles.push_back(handle);
+  return closed;
+}
+
+void FileTable::close_all(void) {
+  handles.clear();
+  free_handles.clear();
+}
+
+bool InputReader::fill(void) {
+  if (eof) return false;
+  if (buffer.empty()) buffer.resize(BUFFER_SIZE);
+  const std::size_t left = end - position;
+  // a token longer than the window
+  if (left == buffer.size()) buffer.resize(buffer.size() * 2);
+  std::memmove(buffer.data(), buffer.data() + position, left);
+  position = 0;
+  end = left;
+  ssize_t got = read_some(fd, buffer.data() + end, buffer.size() - end);
+  if (got <= 0) {
+    eof = true;
+    return false;
+  }
+  end += got;
+  return true;
+}
+
+bool InputReader::read_line(std::string &out) {
+  bool found = false;
+  while (true) {
+    const char *start = buffer.data() + position;
+    const char *newline = position == end ? nullptr : (const char *)std::memchr(start, '\n', end - position);
+    if (newline != nullptr) {
+      out.append(start, newline);
+      position += newline - start + 1;
+      return true;
+    }
+    if (position != end) {
+      found = true;
+      out.append(start, end - position);
+      position = end;
+    }
+    if (!fill()) return found;
+  }
+}
+
+void InputReader::read_all(std::string &out) {
+  out.append(buffer.data() + position, end - position);
+  position = end = 0;
+  if (eof) return;
+  std::size_t size = out.size();
+  out.resize(std::max(size * 2, size + BUFFER_SIZE));
+  while (true) {
+    ssize_t got = read_some(fd, out.data() + size, out.size() - size);
+    if (got <= 0) break;
+    size += got;
+    if (size == out.size()) out.resize(size * 2);
+  }
+  out.resize(size);
+  eof = true;
+}
+
+static inline bool is_space(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool InputReader::read_token(std::string_view &token) {
+  while (true) {
+    while (position != end && is_space(buffer[position])) position++;
+    if (position != end) break;
+    if (!fill()) return false;
+  }
+  std::size_t token_end = position;
+  while (true) {
+    while (token_end != end && !is_space(buffer[token_end])) token_end++;
+    if (token_end != end) break;
+    // the token might go on in the next read, it stays in front of the window
+    const std::size_t length = token_end - position;
+    if (!fill()) {
+      token_end = position + length;
+      break;
+    }
+    token_end = position + length;
+  }
+  token = std::string_view(buffer.data() + position, token_end - position);
+  position = token_end;
+  return true;
+}
+
+bool read_file(const std::string &path, std::string &out) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat info;
+  // files in /proc and pipes report no size, they're read until the end like the rest
+  std::size_t capacity = fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 ? info.st_size + 1 : 1 << 16;
+  out.clear();
+  out.resize(capacity);
+  std::size_t size = 0;
+  while (true) {
+    if (size == out.size()) out.resize(out.size() * 2);
+    ssize_t count = read(fd, out.data() + size, out.size() - size);
+    if (count == -1 && errno == EINTR) continue;
+    if (count <= 0) {
+      close(fd);
+      out.resize(size);
+      return count == 0;
+    }
+    size += count;
+  }
+}
@@ -0,0 +1,125 @@
+#if !defined(__FILES_)
+#define __FILES_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Files read without going through iostreams.
+
+// read-only mapping of a whole file, the pages are loaded by the kernel when they're first read
+class MappedFile {
+  private:
+    void *data = nullptr;
+    std::size_t size = 0;
+  public:
+    // returns nullptr when the file can't be opened or mapped
+    static std::shared_ptr<MappedFile> open(const std::string &path);
+    MappedFile(void *_data, std::size_t _size) : data(_data), size(_size) {};
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+    std::string_view view(void) const { return std::string_view((const char *)data, size); }
+};
+
+// reads a file in large chunks and splits it into lines without copying them,
+// only the chunk with the current line is kept in memory
+class LineReader {
+  private:
+    static constexpr std::size_t CHUNK_SIZE = 1 << 20;
+    int fd = -1;
+    bool eof = false;
+    std::shared_ptr<std::string> chunk;
+    std::size_t position = 0;
+    std::size_t filled = 0;
+    bool fill(void);
+  public:
+    LineReader(const std::string &path);
+    LineReader(const LineReader &) = delete;
+    LineReader &operator=(const LineReader &) = delete;
+    ~LineReader();
+    bool good(void) const { return fd != -1; }
+    // the line is only valid until the next call, owner keeps it alive longer
+    bool next(std::string_view &line, std::shared_ptr<const void> &owner);
+};
+
+// file opened by file_open(), reads and writes go through one large buffer each,
+// a write that doesn't fit is sent together with the buffered bytes in one writev()
+class FileHandle {
+  private:
+    static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+    int fd;
+    bool readable, writable;
+    std::vector<char> write_buffer;
+    std::size_t pending = 0;
+    std::vector<char> read_buffer;
+    std::size_t read_position = 0;
+    std::size_t read_end = 0;
+    bool write_all(const char *first, std::size_t first_size, const char *second, std::size_t second_size);
+    // moves the file position back to the first byte that wasn't read yet
+    bool drop_read_buffer(void);
+  public:
+    FileHandle(int _fd, bool _readable, bool _writable) : fd(_fd), readable(_readable), writable(_writable) {};
+    FileHandle(const FileHandle &) = delete;
+    FileHandle &operator=(const FileHandle &) = delete;
+    ~FileHandle();
+    // mode is one of r, w, a, r+, w+, a+ like in fopen, returns nullptr when the file can't be opened
+    static std::unique_ptr<FileHandle> open(const std::string &path, std::string_view mode, std::string &error);
+    bool can_read(void) const { return readable; }
+    bool can_write(void) const { return writable; }
+    bool write(std::string_view data);
+    // appends up to count bytes to out, fewer only at the end of the file
+    bool read(std::size_t count, std::string &out);
+    // whence is SEEK_SET, SEEK_CUR or SEEK_END, returns the new position or -1
+    std::int64_t seek(std::int64_t offset, int whence);
+    bool flush(void);
+    bool close(void);
+};
+
+// handles of the open files are indexes into the table
+// a script can leave without closing them, whatever is still buffered is written when the interpreter exits
+class FileTable {
+  private:
+    std::vector<std::unique_ptr<FileHandle>> handles;
+    std::vector<std::int64_t> free_handles;
+  public:
+    FileTable(void);
+    FileTable(const FileTable &) = delete;
+    FileTable &operator=(const FileTable &) = delete;
+    ~FileTable();
+    std::int64_t add(std::unique_ptr<FileHandle> file);
+    // nullptr for handles that were never opened or are closed already
+    FileHandle *get(std::int64_t handle);
+    bool close(std::int64_t handle);
+    void close_all(void);
+};
+
+// standard input for input() and the read_* natives, read through one large window
+// lines and tokens are parsed straight out of it
+class InputReader {
+  private:
+    static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+    int fd;
+    std::vector<char> buffer;
+    std::size_t position = 0;
+    std::size_t end = 0;
+    bool eof = false;
+    // moves the unread bytes to the front and reads after them, false when nothing more could be read
+    bool fill(void);
+  public:
+    InputReader(int _fd = 0) : fd(_fd) {};
+    // appends the next line without its newline, false at the end of the input
+    bool read_line(std::string &out);
+    // appends everything that wasn't read yet
+    void read_all(std::string &out);
+    // skips whitespace, token is valid until the next read, false at the end of the input
+    bool read_token(std::string_view &token);
+};
+
+// the whole file with one allocation and no intermediate copies, returns false when it can't be read
+bool read_file(const std::string &path, std::string &out);
+
+#endif // __FILES_
@@ -17,6 +17,7 @@ void Interpreter::process_file(const std::string &filename, int argc, char *argv
   Parser parser(tokens, Token::TokenType::NONE, "", utils);
   const Node &AST = parser.parse(NULL);
   CVM VM;
+  VM.output.set_mode(output_mode, output_threshold);
   Evaluator evaluator(AST, VM, utils);
   evaluator.stack.reserve(100);
   // pass the "arguments" array
@@ -24,10 +25,11 @@ void Interpreter::process_file(const std::string &filename, int argc, char *argv
   var->type = Utils::ARR;
   var->val.array_type = "str";
   var->val.type = Utils::ARR;
-  var->val.array_values.resize(argc);
+  std::vector<Value> &args = var->val.mut_array().values;
+  args.resize(argc);
   for (int i = 0; i < argc; i++) {
-    var->val.array_values[i].type = Utils::STR;
-    var->val.array_values[i].string_value = argv[i];
+    args[i].type = Utils::STR;
+    args[i].string_value = argv[i];
   }
   evaluator.start();
 }
\ No newline at end of file
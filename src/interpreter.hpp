@@ -2,9 +2,15 @@
 #define __INTERPRETER_
 
 #include <string>
+#include <cstddef>
+
+#include "output.hpp"
 
 class Interpreter {
   public:
+    // buffering of the standard output, set by --output
+    OutputBuffer::Mode output_mode = OutputBuffer::AUTO;
+    std::size_t output_threshold = OutputBuffer::DEFAULT_THRESHOLD;
     void process_file(const std::string &filename, int argc, char *argv[]);
 };
 
@@ -15,7 +15,10 @@
 static const char *_builtin_types[] = {
   "int", "double",
   "func", "str", "void",
-  "obj", "arr", "bool"
+  "obj", "arr", "bool",
+  "builder", "map", "hashset",
+  "omap", "deque", "pqueue", "stream",
+  "regex"
 };
 
 static const char *const regex_actual[] = {
@@ -178,6 +181,15 @@ TokenList Lexer::tokenize(const std::string &code) {
         } else if (token_str == "const") {
           log("token [CONST], ");
           add_token(Token::CONST);
+        } else if (token_str == "switch") {
+          log("token [SWITCH], ");
+          add_token(Token::SWITCH);
+        } else if (token_str == "case") {
+          log("token [CASE], ");
+          add_token(Token::CASE);
+        } else if (token_str == "default") {
+          log("token [DEFAULT], ");
+          add_token(Token::DEFAULT);
         } else {
           const char *found_type = NULL;
           for (int i = 0; i < Lexer::types_count; i++) {
@@ -0,0 +1,81 @@
+#include "output.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <unistd.h>
+
+OutputBuffer *OutputBuffer::active = nullptr;
+
+bool OutputBuffer::parse_mode(std::string_view spec, Mode &mode, std::size_t &threshold) {
+  if (spec == "none") {
+    mode = UNBUFFERED;
+  } else if (spec == "line") {
+    mode = LINE;
+  } else if (spec == "full") {
+    mode = FULL;
+  } else if (spec.substr(0, 5) == "full:") {
+    const char *end = spec.data() + spec.size();
+    auto [ptr, ec] = std::from_chars(spec.data() + 5, end, threshold);
+    if (ec != std::errc() || ptr != end || threshold == 0) return false;
+    mode = FULL;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool write_all(int fd, const char *data, std::size_t size) {
+  while (size > 0) {
+    ssize_t written = write(fd, data, size);
+    if (written == -1) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+void OutputBuffer::write_error(std::string_view message) {
+  if (active == nullptr) {
+    write_all(1, message.data(), message.size());
+    return;
+  }
+  active->append(message);
+  active->flush();
+}
+
+OutputBuffer::OutputBuffer(int _fd) : fd(_fd) {
+  set_mode(AUTO);
+  // exit() and runtime errors leave through std::exit, which doesn't destroy the VM
+  static const bool registered = std::atexit(flush_active) == 0;
+  (void)registered;
+  active = this;
+}
+
+OutputBuffer::~OutputBuffer() {
+  flush();
+  if (active == this) active = nullptr;
+}
+
+void OutputBuffer::set_mode(Mode _mode, std::size_t _threshold) {
+  flush();
+  mode = _mode == AUTO ? (isatty(fd) ? LINE : FULL) : _mode;
+  threshold = _threshold;
+  // a huge threshold is only a limit, the buffer grows up to it as output comes in
+  buffer.reserve(std::min(threshold, DEFAULT_THRESHOLD));
+}
+
+bool OutputBuffer::flush(void) {
+  const bool written = write_all(fd, buffer.data(), buffer.size());
+  buffer.clear();
+  scanned = 0;
+  return written;
+}
+
+void OutputBuffer::flush_active(void) {
+  if (active != nullptr) active->flush();
+}
@@ -0,0 +1,64 @@
+#if !defined(__OUTPUT_)
+#define __OUTPUT_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Buffered standard output.
+// print(), println(), stack traces and runtime errors all write into the buffer of the VM, so they come out in order
+// and printing doesn't cost a system call per value. What's left in it is written when the interpreter exits.
+
+class OutputBuffer {
+  public:
+    typedef enum mode {
+      // a write for every print
+      UNBUFFERED,
+      // flushed at the end of a print that contains a newline
+      LINE,
+      // flushed when the threshold is reached
+      FULL,
+      // line buffered on a terminal, fully buffered otherwise
+      AUTO
+    } Mode;
+    static constexpr std::size_t DEFAULT_THRESHOLD = 1 << 16;
+    // parses none, line, full or full:<bytes>, returns false if it's none of them
+    static bool parse_mode(std::string_view spec, Mode &mode, std::size_t &threshold);
+    // lexer and parser errors come before there is a VM, they're written straight to stdout then
+    static void write_error(std::string_view message);
+  private:
+    // the buffer of the running VM, flushed at exit
+    static OutputBuffer *active;
+    static void flush_active(void);
+    int fd;
+    Mode mode;
+    std::size_t threshold = DEFAULT_THRESHOLD;
+    std::string buffer;
+    // newlines before this position were looked for already
+    std::size_t scanned = 0;
+  public:
+    OutputBuffer(int _fd = 1);
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+    ~OutputBuffer();
+    void set_mode(Mode _mode, std::size_t _threshold = DEFAULT_THRESHOLD);
+    void append(std::string_view str) { buffer.append(str); }
+    void append(char c) { buffer.push_back(c); }
+    // for writers that append on their own, written() has to follow
+    std::string &data(void) { return buffer; }
+    // called at the end of every print, flushes according to the mode
+    void written(void) {
+      if (mode == UNBUFFERED || buffer.size() >= threshold || (mode == LINE && buffer.find('\n', scanned) != std::string::npos)) {
+        flush();
+      } else {
+        scanned = buffer.size();
+      }
+    }
+    // a prompt printed without a newline has to show up before input is read
+    void before_input(void) {
+      if (mode == LINE) flush();
+    }
+    bool flush(void);
+};
+
+#endif // __OUTPUT_
@@ -6,6 +6,8 @@
 #include <vector>
 #include <iostream>
 #include <unordered_set>
+#include <cstdint>
+#include <cerrno>
 
 typedef Expression::ExprType ExprType;
 typedef Declaration::DeclType DeclType;
@@ -565,14 +567,111 @@ Node Parser::get_statement(Node &prev, TokenType stop) {
       std::string msg = "invalid for statement. Expected '(', but " + curr_token.get_name() + " found";
       throw_error(msg, curr_token.line);
     }
+    advance(); // skip the (
+    if (curr_token.type == Token::TYPE && lookahead(1).type == Token::IDENTIFIER && lookahead(2).type == Token::COLON) {
+      // for (type identifier : expression) statement
+      Node for_each = Node((Statement(StmtType::FOR_EACH)));
+      for_each.stmt.line = line;
+      for_each.stmt.source = source;
+      Node var_decl = Node((Declaration(DeclType::VAR_DECL)));
+      var_decl.decl.var_type = curr_token.value;
+      advance(); // skip the type
+      var_decl.decl.id = curr_token.value;
+      advance(); // skip the identifier
+      advance(); // skip the :
+      for_each.stmt.declaration.push_back(var_decl);
+      for_each.stmt.expressions.push_back(get_expression(Token::RIGHT_PAREN));
+      advance(); // skip the )
+      for_each.stmt.statements.push_back(get_statement(prev, stop));
+      return for_each;
+    }
     Node for_stmt = Node((Statement(StmtType::FOR)));
     for_stmt.stmt.line = line;
     for_stmt.stmt.source = source;
-    advance(); // skip the (
     for_stmt.stmt.expressions = get_many_expressions(Token::SEMI_COLON, Token::RIGHT_PAREN);
     advance(); // skip the )
     for_stmt.stmt.statements.push_back(get_statement(prev, stop));
     return for_stmt;
+  } else if (curr_token.type == Token::SWITCH) {
+    // switch (expression) { case literal: statement(s) ... default: statement(s) }
+    Node switch_stmt = Node((Statement(StmtType::SWITCH)));
+    switch_stmt.stmt.line = curr_token.line;
+    switch_stmt.stmt.source = curr_token.source;
+    advance(); // skip the switch keyword
+    if (curr_token.type != Token::LEFT_PAREN) {
+      std::string msg = "invalid switch statement. Expected '(', but " + curr_token.get_name() + " found";
+      throw_error(msg, curr_token.line);
+    }
+    advance(); // skip the (
+    switch_stmt.stmt.expressions.push_back(get_expression(Token::RIGHT_PAREN));
+    advance(); // skip the )
+    if (curr_token.type != Token::LEFT_BRACE) {
+      std::string msg = "invalid switch statement. Expected '{', but " + curr_token.get_name() + " found";
+      throw_error(msg, curr_token.line);
+    }
+    advance(); // skip the {
+    auto table = std::make_shared<SwitchTable>();
+    NodeList &body = switch_stmt.stmt.statements;
+    while (curr_token.type != Token::RIGHT_BRACE) {
+      fail_if_EOF(Token::RIGHT_BRACE);
+      if (curr_token.type == Token::CASE) {
+        advance(); // skip the case
+        const bool negative = curr_token.type == Token::OP_MINUS;
+        if (negative) {
+          advance(); // skip the -
+        }
+        const int base = (int)base_lut[(int)curr_token.type];
+        const bool is_string = curr_token.type == Token::STRING_LITERAL && !negative;
+        if (!base && !is_string) {
+          std::string msg = "invalid case label. Expected an integer or a string literal, but " + curr_token.get_name() + " found";
+          throw_error(msg, curr_token.line);
+        }
+        if (table->cases != 0 && table->string_cases != is_string) {
+          throw_error("all case labels of a switch have to be of the same type", curr_token.line);
+        }
+        table->string_cases = is_string;
+        bool added;
+        if (is_string) {
+          added = table->add(Symbol(curr_token.value).str(), body.size());
+        } else {
+          // the lexer keeps a '-' that touches the number in the token
+          const char *digits = curr_token.value.c_str();
+          const bool minus = negative != (*digits == '-');
+          if (*digits == '-') digits++;
+          // the magnitude is checked before negating, INT64_MIN is the only label bigger than INT64_MAX
+          errno = 0;
+          const std::uint64_t magnitude = strtoull(digits, NULL, base);
+          const std::uint64_t limit = minus ? (std::uint64_t)INT64_MAX + 1 : (std::uint64_t)INT64_MAX;
+          if (errno == ERANGE || magnitude > limit) {
+            throw_error("case label " + std::string(minus ? "-" : "") + digits + " doesn't fit in an int", curr_token.line);
+          }
+          const std::int64_t label = minus ? -(std::int64_t)(magnitude - 1) - 1 : (std::int64_t)magnitude;
+          added = table->add(label, body.size());
+        }
+        if (!added) {
+          throw_error("duplicate case label " + curr_token.value, curr_token.line);
+        }
+        advance(); // skip the label
+      } else if (curr_token.type == Token::DEFAULT) {
+        if (table->default_case != SwitchTable::NO_CASE) {
+          throw_error("multiple default labels in one switch", curr_token.line);
+        }
+        table->default_case = body.size();
+        advance(); // skip the default
+      } else {
+        body.push_back(get_statement(prev, stop));
+        continue;
+      }
+      if (curr_token.type != Token::COLON) {
+        std::string msg = "invalid case label. Expected ':', but " + curr_token.get_name() + " found";
+        throw_error(msg, curr_token.line);
+      }
+      advance(); // skip the :
+    }
+    advance(); // skip the }
+    table->build_jumps();
+    switch_stmt.stmt.switch_table = table;
+    return switch_stmt;
   } else if (curr_token.type == Token::RETURN) {
     // return expression;
     Node return_stmt((Statement(StmtType::RETURN)));
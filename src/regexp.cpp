@@ -0,0 +1,720 @@
+#include "regexp.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// sizes above these are refused, so a pattern can't make the interpreter run out of memory
+static const std::size_t MAX_PROGRAM = 1 << 16;
+static const int MAX_REPEAT = 1000;
+static const int INFINITE = -1;
+
+class RegexNode {
+  public:
+    typedef enum kind {
+      EMPTY, BYTE, ANY, CLASS, CONCAT, ALTERNATE, REPEAT, GROUP, ASSERTION
+    } Kind;
+    Kind kind;
+    unsigned char byte = 0;
+    // CLASS: index of the class, GROUP: group number or 0 for (?:), ASSERTION: the instruction
+    std::uint32_t index = 0;
+    int min = 0, max = 0;
+    bool greedy = true;
+    std::vector<RegexNode> children;
+    RegexNode(Kind _kind) : kind(_kind) {};
+};
+
+static bool is_word(unsigned char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static std::bitset<256> class_of(char escape) {
+  std::bitset<256> set;
+  const char lower = escape | 0x20;
+  for (int c = 0; c < 256; c++) {
+    if (lower == 'd') set[c] = c >= '0' && c <= '9';
+    if (lower == 'w') set[c] = is_word(c);
+    if (lower == 's') set[c] = c == ' ' || (c >= '\t' && c <= '\r');
+  }
+  return escape == lower ? set : ~set;
+}
+
+class RegexParser {
+  private:
+    std::string_view pattern;
+    std::size_t pos = 0;
+    std::vector<std::bitset<256>> &classes;
+    std::size_t &groups;
+    bool at_end(void) const { return pos >= pattern.size(); }
+    char peek(void) const { return pattern[pos]; }
+    bool fail(const std::string &cause) {
+      if (error.empty()) error = cause + " at position " + std::to_string(pos);
+      return false;
+    }
+    std::uint32_t add_class(const std::bitset<256> &set) {
+      classes.push_back(set);
+      return classes.size() - 1;
+    }
+    bool parse_escape(RegexNode &node, bool in_class);
+    bool parse_class(RegexNode &node);
+    bool parse_count(int &min, int &max);
+    bool parse_atom(RegexNode &node);
+    bool parse_concat(RegexNode &node);
+  public:
+    std::string error;
+    RegexParser(std::string_view _pattern, std::vector<std::bitset<256>> &_classes, std::size_t &_groups) :
+      pattern(_pattern),
+      classes(_classes),
+      groups(_groups) {};
+    bool parse_alternation(RegexNode &node);
+    bool finished(void) {
+      if (!at_end()) return fail("unmatched ')'");
+      return true;
+    }
+};
+
+// the character after a backslash, pos is on it
+bool RegexParser::parse_escape(RegexNode &node, bool in_class) {
+  if (at_end()) return fail("pattern ends with a backslash");
+  char c = pattern[pos++];
+  // string literals turn \b into a backspace, so "\\b" reaches the pattern as a backslash and a backspace
+  if (c == '\b') c = 'b';
+  node.kind = RegexNode::BYTE;
+  switch (c) {
+    case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+      node.kind = RegexNode::CLASS;
+      node.index = add_class(class_of(c));
+      return true;
+    case 'b':
+      if (in_class) {
+        node.byte = '\b';
+        return true;
+      }
+      node.kind = RegexNode::ASSERTION;
+      node.index = RegexInstruction::WORD_BOUNDARY;
+      return true;
+    case 'B':
+      if (in_class) return fail("invalid escape \\B in a class");
+      node.kind = RegexNode::ASSERTION;
+      node.index = RegexInstruction::NOT_WORD_BOUNDARY;
+      return true;
+    case 'n': node.byte = '\n'; return true;
+    case 't': node.byte = '\t'; return true;
+    case 'r': node.byte = '\r'; return true;
+    case 'f': node.byte = '\f'; return true;
+    case 'v': node.byte = '\v'; return true;
+    case '0': node.byte = '\0'; return true;
+    case 'x': {
+      if (pos + 2 > pattern.size() || !std::isxdigit((unsigned char)pattern[pos]) || !std::isxdigit((unsigned char)pattern[pos + 1])) {
+        return fail("\\x expects two hex digits");
+      }
+      node.byte = std::stoi(std::string(pattern.substr(pos, 2)), nullptr, 16);
+      pos += 2;
+      return true;
+    }
+  }
+  if (c >= '1' && c <= '9') return fail("backreferences are not supported");
+  if (std::isalnum((unsigned char)c)) return fail(std::string("unknown escape \\") + c);
+  node.byte = c;
+  return true;
+}
+
+// [abc], [^a-z], pos is after the [
+bool RegexParser::parse_class(RegexNode &node) {
+  std::bitset<256> set;
+  const bool negated = !at_end() && peek() == '^';
+  if (negated) pos++;
+  while (true) {
+    if (at_end()) return fail("unterminated character class");
+    if (peek() == ']') {
+      pos++;
+      break;
+    }
+    RegexNode from(RegexNode::BYTE);
+    if (peek() == '\\') {
+      pos++;
+      if (!parse_escape(from, true)) return false;
+    } else {
+      from.byte = pattern[pos++];
+    }
+    if (from.kind == RegexNode::CLASS) {
+      set |= classes[from.index];
+      classes.pop_back();
+      continue;
+    }
+    if (pos + 1 < pattern.size() && peek() == '-' && pattern[pos + 1] != ']') {
+      pos++; // skip the -
+      RegexNode to(RegexNode::BYTE);
+      if (peek() == '\\') {
+        pos++;
+        if (!parse_escape(to, true)) return false;
+        if (to.kind == RegexNode::CLASS) return fail("invalid range in a character class");
+      } else {
+        to.byte = pattern[pos++];
+      }
+      if (to.byte < from.byte) return fail("invalid range in a character class");
+      for (int c = from.byte; c <= to.byte; c++) set[c] = true;
+    } else {
+      set[from.byte] = true;
+    }
+  }
+  node.kind = RegexNode::CLASS;
+  node.index = add_class(negated ? ~set : set);
+  return true;
+}
+
+// {n}, {n,} or {n,m}, pos is on the {, nothing is consumed when it's a literal {
+bool RegexParser::parse_count(int &min, int &max) {
+  std::size_t end = pattern.find('}', pos);
+  if (end == std::string_view::npos) return false;
+  const std::string_view body = pattern.substr(pos + 1, end - pos - 1);
+  const std::size_t comma = body.find(',');
+  const std::string_view low = body.substr(0, comma);
+  const std::string_view high = comma == std::string_view::npos ? low : body.substr(comma + 1);
+  auto digits = [](std::string_view str) {
+    return !str.empty() && str.size() <= 4 && std::all_of(str.begin(), str.end(), [](char c) { return c >= '0' && c <= '9'; });
+  };
+  if (!digits(low) || (!high.empty() && !digits(high))) return false;
+  min = std::stoi(std::string(low));
+  max = high.empty() ? INFINITE : std::stoi(std::string(high));
+  pos = end + 1;
+  return true;
+}
+
+bool RegexParser::parse_atom(RegexNode &node) {
+  const char c = pattern[pos++];
+  switch (c) {
+    case '(': {
+      node.kind = RegexNode::GROUP;
+      if (pattern.substr(pos, 2) == "?:") {
+        pos += 2;
+      } else if (!at_end() && peek() == '?') {
+        return fail("lookarounds are not supported");
+      } else {
+        node.index = groups++;
+      }
+      node.children.emplace_back(RegexNode::EMPTY);
+      if (!parse_alternation(node.children[0])) return false;
+      if (at_end() || peek() != ')') return fail("missing ')'");
+      pos++;
+      return true;
+    }
+    case '[': return parse_class(node);
+    case '.':
+      node.kind = RegexNode::ANY;
+      return true;
+    case '^':
+      node.kind = RegexNode::ASSERTION;
+      node.index = RegexInstruction::TEXT_START;
+      return true;
+    case '$':
+      node.kind = RegexNode::ASSERTION;
+      node.index = RegexInstruction::TEXT_END;
+      return true;
+    case '\\': return parse_escape(node, false);
+    case '*': case '+': case '?': return fail("nothing to repeat");
+  }
+  node.kind = RegexNode::BYTE;
+  node.byte = c;
+  return true;
+}
+
+bool RegexParser::parse_concat(RegexNode &node) {
+  node.kind = RegexNode::CONCAT;
+  while (!at_end() && peek() != '|' && peek() != ')') {
+    RegexNode atom(RegexNode::EMPTY);
+    if (!parse_atom(atom)) return false;
+    if (at_end()) {
+      node.children.push_back(std::move(atom));
+      break;
+    }
+    int min = -2, max = 0;
+    const char q = peek();
+    if (q == '*') min = 0, max = INFINITE;
+    if (q == '+') min = 1, max = INFINITE;
+    if (q == '?') min = 0, max = 1;
+    if (min != -2) {
+      pos++;
+    } else if (q != '{' || !parse_count(min, max)) {
+      node.children.push_back(std::move(atom));
+      continue;
+    }
+    if (atom.kind == RegexNode::ASSERTION) return fail("nothing to repeat");
+    if (max != INFINITE && max < min) return fail("numbers out of order in {} quantifier");
+    if (min > MAX_REPEAT || max > MAX_REPEAT) return fail("repetition count is too large");
+    RegexNode repeat(RegexNode::REPEAT);
+    repeat.min = min;
+    repeat.max = max;
+    if (!at_end() && peek() == '?') {
+      repeat.greedy = false;
+      pos++;
+    }
+    if (!at_end() && (peek() == '*' || peek() == '+' || peek() == '?')) return fail("nothing to repeat");
+    repeat.children.push_back(std::move(atom));
+    node.children.push_back(std::move(repeat));
+  }
+  return true;
+}
+
+bool RegexParser::parse_alternation(RegexNode &node) {
+  RegexNode first(RegexNode::CONCAT);
+  if (!parse_concat(first)) return false;
+  if (at_end() || peek() != '|') {
+    node = std::move(first);
+    return true;
+  }
+  node.kind = RegexNode::ALTERNATE;
+  node.children.push_back(std::move(first));
+  while (!at_end() && peek() == '|') {
+    pos++; // skip the |
+    RegexNode next(RegexNode::CONCAT);
+    if (!parse_concat(next)) return false;
+    node.children.push_back(std::move(next));
+  }
+  return true;
+}
+
+class RegexEmitter {
+  private:
+    std::vector<RegexInstruction> &program;
+    std::uint32_t emit(RegexInstruction::Op op, std::uint32_t x = 0, std::uint32_t y = 0) {
+      program.emplace_back(op, x, y);
+      return program.size() - 1;
+    }
+    std::uint32_t pc(void) const { return program.size(); }
+  public:
+    RegexEmitter(std::vector<RegexInstruction> &_program) : program(_program) {};
+    bool emit(const RegexNode &node);
+};
+
+bool RegexEmitter::emit(const RegexNode &node) {
+  if (program.size() > MAX_PROGRAM) return false;
+  switch (node.kind) {
+    case RegexNode::EMPTY:
+      return true;
+    case RegexNode::BYTE:
+      program[emit(RegexInstruction::BYTE)].byte = node.byte;
+      return true;
+    case RegexNode::ANY:
+      emit(RegexInstruction::ANY);
+      return true;
+    case RegexNode::CLASS:
+      emit(RegexInstruction::CLASS, node.index);
+      return true;
+    case RegexNode::ASSERTION:
+      emit((RegexInstruction::Op)node.index);
+      return true;
+    case RegexNode::CONCAT:
+      for (const auto &child : node.children) {
+        if (!emit(child)) return false;
+      }
+      return true;
+    case RegexNode::GROUP:
+      if (node.index != 0) emit(RegexInstruction::SAVE, node.index * 2);
+      if (!emit(node.children[0])) return false;
+      if (node.index != 0) emit(RegexInstruction::SAVE, node.index * 2 + 1);
+      return true;
+    case RegexNode::ALTERNATE: {
+      // split to this alternative or the next one, every alternative jumps to the end
+      std::vector<std::uint32_t> jumps;
+      for (std::size_t i = 0; i < node.children.size(); i++) {
+        const bool last = i + 1 == node.children.size();
+        const std::uint32_t split = last ? 0 : emit(RegexInstruction::SPLIT, pc() + 1);
+        if (!emit(node.children[i])) return false;
+        if (!last) {
+          jumps.push_back(emit(RegexInstruction::JUMP));
+          program[split].y = pc();
+        }
+      }
+      for (const auto jump : jumps) {
+        program[jump].x = pc();
+      }
+      return true;
+    }
+    case RegexNode::REPEAT: {
+      const RegexNode &body = node.children[0];
+      for (int i = 0; i < node.min; i++) {
+        if (!emit(body)) return false;
+      }
+      // the preferred branch of a split enters the body when it's greedy
+      auto order = [&](std::uint32_t split, std::uint32_t enter, std::uint32_t leave) {
+        program[split].x = node.greedy ? enter : leave;
+        program[split].y = node.greedy ? leave : enter;
+      };
+      if (node.max == INFINITE) {
+        const std::uint32_t split = emit(RegexInstruction::SPLIT);
+        if (!emit(body)) return false;
+        emit(RegexInstruction::JUMP, split);
+        order(split, split + 1, pc());
+        return true;
+      }
+      std::vector<std::uint32_t> splits;
+      for (int i = node.min; i < node.max; i++) {
+        splits.push_back(emit(RegexInstruction::SPLIT));
+        if (!emit(body)) return false;
+      }
+      for (const auto split : splits) {
+        order(split, split + 1, pc());
+      }
+      return true;
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<Regex> Regex::compile(std::string_view pattern, std::string &error) {
+  auto regex = std::make_shared<Regex>();
+  regex->source = pattern;
+  RegexParser parser(pattern, regex->classes, regex->group_count);
+  RegexNode root(RegexNode::EMPTY);
+  if (!parser.parse_alternation(root) || !parser.finished()) {
+    error = parser.error;
+    return nullptr;
+  }
+  // SAVE 0, pattern, SAVE 1, MATCH
+  regex->program.emplace_back(RegexInstruction::SAVE, 0);
+  RegexEmitter emitter(regex->program);
+  if (!emitter.emit(root) || regex->program.size() > MAX_PROGRAM) {
+    error = "pattern is too large";
+    return nullptr;
+  }
+  regex->program.emplace_back(RegexInstruction::SAVE, 1);
+  regex->program.emplace_back(RegexInstruction::MATCH);
+  regex->analyze();
+  return regex;
+}
+
+void Regex::analyze(void) {
+  for (const auto &instruction : program) {
+    if (instruction.op >= RegexInstruction::TEXT_START && instruction.op <= RegexInstruction::NOT_WORD_BOUNDARY) {
+      has_assertions = true;
+    }
+  }
+  std::size_t pc = 0;
+  while (program[pc].op == RegexInstruction::SAVE || program[pc].op == RegexInstruction::BYTE) {
+    if (program[pc].op == RegexInstruction::BYTE) prefix.push_back(program[pc].byte);
+    pc++;
+  }
+  // bytes that can start a match, assertions are skipped which only makes the set bigger
+  std::vector<bool> seen(program.size());
+  std::vector<std::uint32_t> stack = {0};
+  any_first_byte = false;
+  while (!stack.empty() && !any_first_byte) {
+    const std::uint32_t pc = stack.back();
+    stack.pop_back();
+    if (seen[pc]) continue;
+    seen[pc] = true;
+    const RegexInstruction &instruction = program[pc];
+    switch (instruction.op) {
+      case RegexInstruction::BYTE: first_bytes[instruction.byte] = true; break;
+      case RegexInstruction::ANY: first_bytes |= std::bitset<256>().set().reset('\n').reset('\r'); break;
+      case RegexInstruction::CLASS: first_bytes |= classes[instruction.x]; break;
+      case RegexInstruction::SPLIT: stack.push_back(instruction.y); stack.push_back(instruction.x); break;
+      case RegexInstruction::JUMP: stack.push_back(instruction.x); break;
+      case RegexInstruction::MATCH: any_first_byte = true; break;
+      default: stack.push_back(pc + 1); break;
+    }
+  }
+  if (first_bytes.all()) any_first_byte = true;
+  if (!any_first_byte && first_bytes.count() == 1) {
+    for (first_byte = 0; !first_bytes[first_byte]; first_byte++);
+  }
+}
+
+// first position at or after from where a match can start, npos when there is none
+std::size_t Regex::next_candidate(std::string_view input, std::size_t from) const {
+  if (from > input.size()) return std::string_view::npos;
+  if (!prefix.empty()) return input.find(prefix, from);
+  if (any_first_byte) return from;
+  if (first_byte != -1) {
+    const void *found = std::memchr(input.data() + from, first_byte, input.size() - from);
+    return found == nullptr ? std::string_view::npos : (const char *)found - input.data();
+  }
+  for (std::size_t i = from; i < input.size(); i++) {
+    if (first_bytes[(unsigned char)input[i]]) return i;
+  }
+  return std::string_view::npos;
+}
+
+// threads of one step of the VM, in priority order
+// a sparse set, so clearing it is free and every pc is added once per step
+class RegexThreads {
+  private:
+    std::vector<std::uint32_t> sparse;
+    std::size_t slots;
+  public:
+    std::vector<std::uint32_t> pcs;
+    std::vector<std::size_t> captures;
+    std::size_t count = 0;
+    RegexThreads(std::size_t program_size, std::size_t _slots) :
+      sparse(program_size),
+      slots(_slots),
+      pcs(program_size),
+      captures(program_size * _slots) {};
+    bool insert(std::uint32_t pc) {
+      const std::uint32_t index = sparse[pc];
+      if (index < count && pcs[index] == pc) return false;
+      sparse[pc] = count;
+      pcs[count++] = pc;
+      return true;
+    }
+    std::size_t *captures_of(std::size_t index) { return captures.data() + index * slots; }
+};
+
+class RegexFrame {
+  public:
+    std::uint32_t pc;
+    // restores a capture slot when it's not NO_SLOT
+    std::uint32_t slot;
+    std::size_t old;
+};
+
+static const std::uint32_t NO_SLOT = UINT32_MAX;
+
+// follows jumps, splits, saves and assertions from pc at position sp, the threads that reach a byte test or MATCH are added
+static void add_thread(
+  const std::vector<RegexInstruction> &program, std::string_view input, RegexThreads &threads,
+  std::vector<RegexFrame> &stack, std::uint32_t start, std::size_t sp, std::size_t *captures, std::size_t slots
+) {
+  stack.push_back({start, NO_SLOT, 0});
+  while (!stack.empty()) {
+    const RegexFrame frame = stack.back();
+    stack.pop_back();
+    if (frame.slot != NO_SLOT) {
+      captures[frame.slot] = frame.old;
+      continue;
+    }
+    const std::uint32_t pc = frame.pc;
+    if (!threads.insert(pc)) continue;
+    const RegexInstruction &instruction = program[pc];
+    switch (instruction.op) {
+      case RegexInstruction::JUMP:
+        stack.push_back({instruction.x, NO_SLOT, 0});
+        break;
+      case RegexInstruction::SPLIT:
+        stack.push_back({instruction.y, NO_SLOT, 0});
+        stack.push_back({instruction.x, NO_SLOT, 0});
+        break;
+      case RegexInstruction::SAVE:
+        stack.push_back({0, instruction.x, captures[instruction.x]});
+        captures[instruction.x] = sp;
+        stack.push_back({pc + 1, NO_SLOT, 0});
+        break;
+      case RegexInstruction::TEXT_START:
+        if (sp == 0) stack.push_back({pc + 1, NO_SLOT, 0});
+        break;
+      case RegexInstruction::TEXT_END:
+        if (sp == input.size()) stack.push_back({pc + 1, NO_SLOT, 0});
+        break;
+      case RegexInstruction::WORD_BOUNDARY:
+      case RegexInstruction::NOT_WORD_BOUNDARY: {
+        const bool boundary = (sp > 0 && is_word(input[sp - 1])) != (sp < input.size() && is_word(input[sp]));
+        if (boundary == (instruction.op == RegexInstruction::WORD_BOUNDARY)) stack.push_back({pc + 1, NO_SLOT, 0});
+        break;
+      }
+      default:
+        std::copy(captures, captures + slots, threads.captures_of(threads.count - 1));
+        break;
+    }
+  }
+}
+
+class RegexVM {
+  public:
+    RegexThreads current, next;
+    std::vector<RegexFrame> stack;
+    std::vector<std::size_t> scratch;
+    RegexVM(std::size_t program_size, std::size_t slots) :
+      current(program_size, slots),
+      next(program_size, slots),
+      scratch(slots) {};
+};
+
+Regex::Regex(void) {}
+
+Regex::~Regex() {}
+
+bool Regex::run_vm(std::string_view input, std::size_t from, bool whole, Captures &captures) {
+  const std::size_t slots = group_count * 2;
+  if (vm == nullptr) {
+    vm = std::make_unique<RegexVM>(program.size(), slots);
+  }
+  RegexThreads *current = &vm->current, *next = &vm->next;
+  std::vector<std::size_t> &scratch = vm->scratch;
+  current->count = 0;
+  bool matched = false;
+  std::size_t sp = from;
+  while (true) {
+    if (!matched && (!whole || sp == from)) {
+      if (current->count == 0 && !whole) {
+        sp = next_candidate(input, sp);
+        if (sp == std::string_view::npos) break;
+      }
+      std::fill(scratch.begin(), scratch.end(), NO_MATCH);
+      add_thread(program, input, *current, vm->stack, 0, sp, scratch.data(), slots);
+    }
+    if (current->count == 0) {
+      if (matched || whole || sp >= input.size()) break;
+      sp++;
+      continue;
+    }
+    next->count = 0;
+    const unsigned char c = sp < input.size() ? input[sp] : 0;
+    for (std::size_t i = 0; i < current->count; i++) {
+      const RegexInstruction &instruction = program[current->pcs[i]];
+      std::size_t *thread_captures = current->captures_of(i);
+      bool accepts = false;
+      switch (instruction.op) {
+        case RegexInstruction::MATCH:
+          if (whole && sp != input.size()) break;
+          captures.assign(thread_captures, thread_captures + slots);
+          matched = true;
+          // the threads after this one have a lower priority
+          i = current->count;
+          break;
+        case RegexInstruction::BYTE: accepts = c == instruction.byte; break;
+        case RegexInstruction::ANY: accepts = c != '\n' && c != '\r'; break;
+        case RegexInstruction::CLASS: accepts = classes[instruction.x][c]; break;
+        default: break;
+      }
+      if (accepts && sp < input.size()) {
+        std::copy(thread_captures, thread_captures + slots, scratch.begin());
+        add_thread(program, input, *next, vm->stack, current->pcs[i] + 1, sp + 1, scratch.data(), slots);
+      }
+    }
+    std::swap(current, next);
+    if (sp >= input.size()) break;
+    sp++;
+  }
+  return matched;
+}
+
+bool Regex::match(std::string_view input) {
+  if (!has_assertions) {
+    if (anchored_dfa == nullptr) {
+      anchored_dfa = std::make_unique<RegexDFA>(program, classes, false);
+    }
+    std::size_t restart;
+    const bool matched = anchored_dfa->run(input, restart);
+    if (!anchored_dfa->failed) return matched;
+  }
+  Captures captures;
+  return run_vm(input, 0, true, captures);
+}
+
+bool Regex::search(std::string_view input, std::size_t from, Captures &captures) {
+  if (from > input.size()) return false;
+  if (!has_assertions) {
+    if (floating_dfa == nullptr) {
+      floating_dfa = std::make_unique<RegexDFA>(program, classes, true);
+    }
+    // the DFA finds out if there is a match and skips the bytes where none can start, the VM finds its groups
+    std::size_t restart = 0;
+    const bool found = floating_dfa->run(input.substr(from), restart);
+    if (!floating_dfa->failed) {
+      if (!found) return false;
+      from += restart;
+    }
+  }
+  return run_vm(input, from, false, captures);
+}
+
+RegexDFA::RegexDFA(const std::vector<RegexInstruction> &_program, const std::vector<std::bitset<256>> &_classes, bool _floating) :
+  program(_program),
+  classes(_classes),
+  floating(_floating) {
+  std::vector<bool> seen(program.size());
+  bool match = false;
+  closure(0, start_pcs, seen, match);
+  std::vector<std::uint32_t> pcs = start_pcs;
+  add_state(pcs, (match ? MATCH : 0) | RESTART);
+}
+
+// byte tests and MATCH reachable from pc without consuming input
+void RegexDFA::closure(std::uint32_t pc, std::vector<std::uint32_t> &pcs, std::vector<bool> &seen, bool &match) const {
+  std::vector<std::uint32_t> stack = {pc};
+  while (!stack.empty()) {
+    const std::uint32_t pc = stack.back();
+    stack.pop_back();
+    if (seen[pc]) continue;
+    seen[pc] = true;
+    const RegexInstruction &instruction = program[pc];
+    switch (instruction.op) {
+      case RegexInstruction::SPLIT: stack.push_back(instruction.y); stack.push_back(instruction.x); break;
+      case RegexInstruction::JUMP: stack.push_back(instruction.x); break;
+      case RegexInstruction::SAVE: stack.push_back(pc + 1); break;
+      case RegexInstruction::MATCH: match = true; break;
+      default: pcs.push_back(pc); break;
+    }
+  }
+}
+
+std::int32_t RegexDFA::add_state(std::vector<std::uint32_t> &pcs, std::uint8_t state_flags) {
+  std::sort(pcs.begin(), pcs.end());
+  std::string key(reinterpret_cast<const char *>(pcs.data()), pcs.size() * sizeof(std::uint32_t));
+  key.push_back(state_flags);
+  auto it = state_ids.find(key);
+  if (it != state_ids.end()) return it->second;
+  if (states.size() == MAX_STATES) {
+    failed = true;
+    return UNKNOWN;
+  }
+  states.push_back(pcs);
+  flags.push_back(state_flags);
+  transitions.resize(states.size() * 256, UNKNOWN);
+  state_ids.emplace(std::move(key), states.size() - 1);
+  return states.size() - 1;
+}
+
+std::int32_t RegexDFA::step(std::int32_t state, unsigned char byte) {
+  std::vector<std::uint32_t> pcs;
+  std::vector<bool> seen(program.size());
+  bool match = false;
+  for (const auto pc : states[state]) {
+    const RegexInstruction &instruction = program[pc];
+    bool accepts = false;
+    if (instruction.op == RegexInstruction::BYTE) accepts = byte == instruction.byte;
+    if (instruction.op == RegexInstruction::ANY) accepts = byte != '\n' && byte != '\r';
+    if (instruction.op == RegexInstruction::CLASS) accepts = classes[instruction.x][byte];
+    if (accepts) closure(pc + 1, pcs, seen, match);
+  }
+  std::uint8_t state_flags = match ? MATCH : 0;
+  if (floating) {
+    if (pcs.empty() && !match) state_flags |= RESTART;
+    for (const auto pc : start_pcs) {
+      if (!seen[pc]) {
+        seen[pc] = true;
+        pcs.push_back(pc);
+      }
+    }
+  }
+  const std::int32_t next = add_state(pcs, state_flags);
+  if (next != UNKNOWN) {
+    transitions[state * 256 + byte] = next;
+  }
+  return next;
+}
+
+bool RegexDFA::run(std::string_view input, std::size_t &restart) {
+  if (failed) return false;
+  std::int32_t state = 0;
+  restart = 0;
+  if (floating && (flags[0] & MATCH)) return true;
+  for (std::size_t i = 0; i < input.size(); i++) {
+    const unsigned char byte = input[i];
+    std::int32_t next = transitions[state * 256 + byte];
+    if (next == UNKNOWN) {
+      next = step(state, byte);
+      if (next == UNKNOWN) return false;
+    }
+    state = next;
+    if (floating) {
+      if (flags[state] & RESTART) restart = i + 1;
+      if (flags[state] & MATCH) return true;
+    } else if (states[state].empty()) {
+      // nothing can consume the rest of the input
+      return (flags[state] & MATCH) && i + 1 == input.size();
+    }
+  }
+  return flags[state] & MATCH;
+}
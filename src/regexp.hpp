@@ -0,0 +1,106 @@
+#if !defined(__REGEXP_)
+#define __REGEXP_
+
+#include <bitset>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Regular expressions for the regex_* natives.
+// A pattern compiles to a program for a Pike VM, which runs every alternative in lockstep instead of backtracking,
+// so matching is linear in the input for any pattern. Programs without assertions also run as a lazily built DFA,
+// which answers whole-input matches and rejects inputs without any match before the VM looks for captures.
+// Supported: literals, ., [classes], \d \w \s and their negations, ^ $ \b \B, capturing and (?:) groups,
+// | and the greedy and lazy forms of * + ? {n} {n,} {n,m}. There are no backreferences or lookarounds.
+// Matches agree with backtracking engines, except where a repeated group can match nothing.
+
+class RegexInstruction {
+  public:
+    typedef enum op {
+      BYTE, ANY, CLASS, SPLIT, JUMP, SAVE, TEXT_START, TEXT_END, WORD_BOUNDARY, NOT_WORD_BOUNDARY, MATCH
+    } Op;
+    Op op;
+    unsigned char byte = 0;
+    // CLASS: index of the class, SPLIT: preferred target, JUMP: target, SAVE: capture slot
+    std::uint32_t x = 0;
+    // SPLIT: the other target
+    std::uint32_t y = 0;
+    RegexInstruction(Op _op, std::uint32_t _x = 0, std::uint32_t _y = 0) : op(_op), x(_x), y(_y) {};
+};
+
+// subset construction of the program, states are built the first time a byte leads to them
+class RegexDFA {
+  private:
+    static constexpr std::size_t MAX_STATES = 4096;
+    static constexpr std::int32_t UNKNOWN = -1;
+    // a match ends after the last byte
+    static constexpr std::uint8_t MATCH = 1;
+    // floating: every match that started before the last byte has failed
+    static constexpr std::uint8_t RESTART = 2;
+    const std::vector<RegexInstruction> &program;
+    const std::vector<std::bitset<256>> &classes;
+    // the start state is merged into every state, so a match can begin anywhere
+    const bool floating;
+    // byte tests of every state
+    std::vector<std::vector<std::uint32_t>> states;
+    std::vector<std::uint8_t> flags;
+    std::vector<std::int32_t> transitions;
+    std::unordered_map<std::string, std::int32_t> state_ids;
+    std::vector<std::uint32_t> start_pcs;
+    void closure(std::uint32_t pc, std::vector<std::uint32_t> &pcs, std::vector<bool> &seen, bool &match) const;
+    std::int32_t add_state(std::vector<std::uint32_t> &pcs, std::uint8_t state_flags);
+    std::int32_t step(std::int32_t state, unsigned char byte);
+  public:
+    // set when the states didn't fit, the VM has to be used then
+    bool failed = false;
+    RegexDFA(const std::vector<RegexInstruction> &_program, const std::vector<std::bitset<256>> &_classes, bool _floating);
+    // anchored: does the whole input match
+    // floating: does any part of it match, restart is where the leftmost match starts at the earliest
+    bool run(std::string_view input, std::size_t &restart);
+};
+
+class RegexVM;
+
+class Regex {
+  public:
+    Regex(void);
+    ~Regex();
+    // start and end of every group in pairs, group 0 is the whole match
+    typedef std::vector<std::size_t> Captures;
+    // captures of groups that didn't take part in the match
+    static constexpr std::size_t NO_MATCH = SIZE_MAX;
+    // returns nullptr and sets error when the pattern is invalid
+    static std::shared_ptr<Regex> compile(std::string_view pattern, std::string &error);
+    const std::string &pattern(void) const { return source; }
+    std::size_t groups(void) const { return group_count; }
+    // the whole input has to match
+    bool match(std::string_view input);
+    // leftmost match that starts at from or later, alternatives on the left and greedy repetitions win
+    bool search(std::string_view input, std::size_t from, Captures &captures);
+  private:
+    std::string source;
+    std::size_t group_count = 1;
+    std::vector<RegexInstruction> program;
+    std::vector<std::bitset<256>> classes;
+    // candidates for the first byte of a match, all of them when a match can be empty or start with an assertion
+    std::bitset<256> first_bytes;
+    bool any_first_byte = true;
+    // set when only one byte can start a match, it is found with memchr
+    int first_byte = -1;
+    // bytes every match starts with
+    std::string prefix;
+    bool has_assertions = false;
+    std::unique_ptr<RegexDFA> anchored_dfa;
+    std::unique_ptr<RegexDFA> floating_dfa;
+    // buffers of the VM, kept between searches
+    std::unique_ptr<RegexVM> vm;
+    void analyze(void);
+    std::size_t next_candidate(std::string_view input, std::size_t from) const;
+    bool run_vm(std::string_view input, std::size_t from, bool whole, Captures &captures);
+};
+
+#endif // __REGEXP_
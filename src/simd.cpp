@@ -0,0 +1,450 @@
+#include "simd.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #define SIMD_X86
+  #include <immintrin.h>
+  #define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// scalar loop for math functions that have no vector instruction
+#define MATH_KERNEL(fn)\
+  void Simd::fn(double *data, std::size_t size) {\
+    for (std::size_t i = 0; i < size; i++) {\
+      data[i] = std::fn(data[i]);\
+    }\
+  }
+
+// picks the AVX2 implementation when available
+#define DISPATCH(avx2_call, scalar_call)\
+  if (avx2_supported()) {\
+    return avx2_call;\
+  }\
+  return scalar_call;
+
+// integer arithmetic wraps in two's complement, the same way the vector lanes do
+static inline std::int64_t wrap_add(std::int64_t a, std::int64_t b) {
+  return (std::int64_t)((std::uint64_t)a + (std::uint64_t)b);
+}
+
+static inline std::int64_t wrap_mul(std::int64_t a, std::int64_t b) {
+  return (std::int64_t)((std::uint64_t)a * (std::uint64_t)b);
+}
+
+// min() and max() of doubles return NaN if any element is NaN
+static const double NOT_A_NUMBER = std::numeric_limits<double>::quiet_NaN();
+
+bool Simd::avx2_supported(void) {
+#if defined(SIMD_X86)
+  // cpuid, also checks that the OS saves the ymm registers
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+#if defined(SIMD_X86)
+
+TARGET_AVX2 static std::int64_t sum_avx2(const std::int64_t *data, std::size_t size) {
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256((const __m256i *)(data + i)));
+    acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256((const __m256i *)(data + i + 4)));
+  }
+  std::int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(acc0, acc1));
+  std::int64_t res = wrap_add(wrap_add(lanes[0], lanes[1]), wrap_add(lanes[2], lanes[3]));
+  for (; i < size; i++) res = wrap_add(res, data[i]);
+  return res;
+}
+
+TARGET_AVX2 static double sum_avx2(const double *data, std::size_t size) {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+    acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i + 4));
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+  double res = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < size; i++) res += data[i];
+  return res;
+}
+
+TARGET_AVX2 static std::int64_t min_avx2(const std::int64_t *data, std::size_t size) {
+  std::size_t i = 0;
+  std::int64_t res = data[0];
+  if (size >= 4) {
+    __m256i acc = _mm256_loadu_si256((const __m256i *)data);
+    for (i = 4; i + 4 <= size; i += 4) {
+      const __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+      acc = _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(acc, v));
+    }
+    std::int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    res = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+  }
+  for (; i < size; i++) res = std::min(res, data[i]);
+  return res;
+}
+
+TARGET_AVX2 static std::int64_t max_avx2(const std::int64_t *data, std::size_t size) {
+  std::size_t i = 0;
+  std::int64_t res = data[0];
+  if (size >= 4) {
+    __m256i acc = _mm256_loadu_si256((const __m256i *)data);
+    for (i = 4; i + 4 <= size; i += 4) {
+      const __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+      acc = _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(v, acc));
+    }
+    std::int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    res = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+  }
+  for (; i < size; i++) res = std::max(res, data[i]);
+  return res;
+}
+
+TARGET_AVX2 static double min_avx2(const double *data, std::size_t size) {
+  std::size_t i = 0;
+  double res = data[0];
+  if (size >= 4) {
+    __m256d acc = _mm256_loadu_pd(data);
+    // min_pd drops NaN in the first operand, so NaN lanes are tracked separately
+    __m256d nans = _mm256_cmp_pd(acc, acc, _CMP_UNORD_Q);
+    for (i = 4; i + 4 <= size; i += 4) {
+      const __m256d v = _mm256_loadu_pd(data + i);
+      nans = _mm256_or_pd(nans, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+      acc = _mm256_min_pd(acc, v);
+    }
+    if (_mm256_movemask_pd(nans) != 0) return NOT_A_NUMBER;
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    res = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+  }
+  for (; i < size; i++) {
+    if (std::isnan(data[i])) return NOT_A_NUMBER;
+    res = std::min(res, data[i]);
+  }
+  return res;
+}
+
+TARGET_AVX2 static double max_avx2(const double *data, std::size_t size) {
+  std::size_t i = 0;
+  double res = data[0];
+  if (size >= 4) {
+    __m256d acc = _mm256_loadu_pd(data);
+    // max_pd drops NaN in the first operand, so NaN lanes are tracked separately
+    __m256d nans = _mm256_cmp_pd(acc, acc, _CMP_UNORD_Q);
+    for (i = 4; i + 4 <= size; i += 4) {
+      const __m256d v = _mm256_loadu_pd(data + i);
+      nans = _mm256_or_pd(nans, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+      acc = _mm256_max_pd(acc, v);
+    }
+    if (_mm256_movemask_pd(nans) != 0) return NOT_A_NUMBER;
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    res = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+  }
+  for (; i < size; i++) {
+    if (std::isnan(data[i])) return NOT_A_NUMBER;
+    res = std::max(res, data[i]);
+  }
+  return res;
+}
+
+TARGET_AVX2 static double dot_avx2(const double *a, const double *b, std::size_t size) {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+  double res = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < size; i++) res += a[i] * b[i];
+  return res;
+}
+
+TARGET_AVX2 static void scale_avx2(double *data, std::size_t size, double factor) {
+  const __m256d f = _mm256_set1_pd(factor);
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(data + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), f));
+  }
+  for (; i < size; i++) data[i] *= factor;
+}
+
+TARGET_AVX2 static void add_avx2(std::int64_t *dst, const std::int64_t *src, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    const __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+    const __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_add_epi64(a, b));
+  }
+  for (; i < size; i++) dst[i] = wrap_add(dst[i], src[i]);
+}
+
+TARGET_AVX2 static void add_avx2(double *dst, const double *src, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(dst + i), _mm256_loadu_pd(src + i)));
+  }
+  for (; i < size; i++) dst[i] += src[i];
+}
+
+TARGET_AVX2 static void fill_avx2(std::int64_t *data, std::size_t size, std::int64_t val) {
+  const __m256i v = _mm256_set1_epi64x(val);
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_si256((__m256i *)(data + i), v);
+  }
+  for (; i < size; i++) data[i] = val;
+}
+
+TARGET_AVX2 static void fill_avx2(double *data, std::size_t size, double val) {
+  const __m256d v = _mm256_set1_pd(val);
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(data + i, v);
+  }
+  for (; i < size; i++) data[i] = val;
+}
+
+TARGET_AVX2 static void sqrt_avx2(double *data, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(data + i, _mm256_sqrt_pd(_mm256_loadu_pd(data + i)));
+  }
+  for (; i < size; i++) data[i] = std::sqrt(data[i]);
+}
+
+TARGET_AVX2 static void floor_avx2(double *data, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(data + i, _mm256_floor_pd(_mm256_loadu_pd(data + i)));
+  }
+  for (; i < size; i++) data[i] = std::floor(data[i]);
+}
+
+TARGET_AVX2 static void ceil_avx2(double *data, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(data + i, _mm256_ceil_pd(_mm256_loadu_pd(data + i)));
+  }
+  for (; i < size; i++) data[i] = std::ceil(data[i]);
+}
+
+#else
+
+// never called, avx2_supported() is always false on these platforms
+#define sum_avx2(...) 0
+#define min_avx2(...) 0
+#define max_avx2(...) 0
+#define dot_avx2(...) 0
+#define scale_avx2(...) (void)0
+#define add_avx2(...) (void)0
+#define fill_avx2(...) (void)0
+#define sqrt_avx2(...) (void)0
+#define floor_avx2(...) (void)0
+#define ceil_avx2(...) (void)0
+
+#endif // SIMD_X86
+
+// scalar implementations
+
+static std::int64_t sum_scalar(const std::int64_t *data, std::size_t size) {
+  std::int64_t res = 0;
+  for (std::size_t i = 0; i < size; i++) res = wrap_add(res, data[i]);
+  return res;
+}
+
+// double sums use the same order as the two AVX2 accumulators: 8 lanes,
+// lane k added to lane k + 4, then pairwise, then the tail left to right
+static double sum_scalar(const double *data, std::size_t size) {
+  double acc[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    for (std::size_t k = 0; k < 8; k++) acc[k] += data[i + k];
+  }
+  double lanes[4];
+  for (std::size_t k = 0; k < 4; k++) lanes[k] = acc[k] + acc[k + 4];
+  double res = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < size; i++) res += data[i];
+  return res;
+}
+
+static std::int64_t min_scalar(const std::int64_t *data, std::size_t size) {
+  std::int64_t res = data[0];
+  for (std::size_t i = 1; i < size; i++) res = std::min(res, data[i]);
+  return res;
+}
+
+static double min_scalar(const double *data, std::size_t size) {
+  double res = data[0];
+  for (std::size_t i = 0; i < size; i++) {
+    if (std::isnan(data[i])) return NOT_A_NUMBER;
+    res = std::min(res, data[i]);
+  }
+  return res;
+}
+
+static std::int64_t max_scalar(const std::int64_t *data, std::size_t size) {
+  std::int64_t res = data[0];
+  for (std::size_t i = 1; i < size; i++) res = std::max(res, data[i]);
+  return res;
+}
+
+static double max_scalar(const double *data, std::size_t size) {
+  double res = data[0];
+  for (std::size_t i = 0; i < size; i++) {
+    if (std::isnan(data[i])) return NOT_A_NUMBER;
+    res = std::max(res, data[i]);
+  }
+  return res;
+}
+
+// same summation order as sum_scalar()
+static double dot_scalar(const double *a, const double *b, std::size_t size) {
+  double acc[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    for (std::size_t k = 0; k < 8; k++) acc[k] += a[i + k] * b[i + k];
+  }
+  double lanes[4];
+  for (std::size_t k = 0; k < 4; k++) lanes[k] = acc[k] + acc[k + 4];
+  double res = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < size; i++) res += a[i] * b[i];
+  return res;
+}
+
+static void scale_scalar(double *data, std::size_t size, double factor) {
+  for (std::size_t i = 0; i < size; i++) data[i] *= factor;
+}
+
+static void add_scalar(std::int64_t *dst, const std::int64_t *src, std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) dst[i] = wrap_add(dst[i], src[i]);
+}
+
+static void add_scalar(double *dst, const double *src, std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) dst[i] += src[i];
+}
+
+template <typename T>
+static void fill_scalar(T *data, std::size_t size, T val) {
+  std::fill(data, data + size, val);
+}
+
+static void sqrt_scalar(double *data, std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) data[i] = std::sqrt(data[i]);
+}
+
+static void floor_scalar(double *data, std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) data[i] = std::floor(data[i]);
+}
+
+static void ceil_scalar(double *data, std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) data[i] = std::ceil(data[i]);
+}
+
+// public interface
+
+std::int64_t Simd::sum(const std::int64_t *data, std::size_t size) {
+  DISPATCH(sum_avx2(data, size), sum_scalar(data, size))
+}
+
+double Simd::sum(const double *data, std::size_t size) {
+  DISPATCH(sum_avx2(data, size), sum_scalar(data, size))
+}
+
+std::int64_t Simd::min(const std::int64_t *data, std::size_t size) {
+  DISPATCH(min_avx2(data, size), min_scalar(data, size))
+}
+
+double Simd::min(const double *data, std::size_t size) {
+  DISPATCH(min_avx2(data, size), min_scalar(data, size))
+}
+
+std::int64_t Simd::max(const std::int64_t *data, std::size_t size) {
+  DISPATCH(max_avx2(data, size), max_scalar(data, size))
+}
+
+double Simd::max(const double *data, std::size_t size) {
+  DISPATCH(max_avx2(data, size), max_scalar(data, size))
+}
+
+std::int64_t Simd::dot(const std::int64_t *a, const std::int64_t *b, std::size_t size) {
+  // AVX2 has no 64 bit multiplication
+  std::int64_t res = 0;
+  for (std::size_t i = 0; i < size; i++) res = wrap_add(res, wrap_mul(a[i], b[i]));
+  return res;
+}
+
+double Simd::dot(const double *a, const double *b, std::size_t size) {
+  DISPATCH(dot_avx2(a, b, size), dot_scalar(a, b, size))
+}
+
+void Simd::scale(std::int64_t *data, std::size_t size, std::int64_t factor) {
+  // AVX2 has no 64 bit multiplication
+  for (std::size_t i = 0; i < size; i++) data[i] = wrap_mul(data[i], factor);
+}
+
+void Simd::scale(double *data, std::size_t size, double factor) {
+  DISPATCH(scale_avx2(data, size, factor), scale_scalar(data, size, factor))
+}
+
+void Simd::add(std::int64_t *dst, const std::int64_t *src, std::size_t size) {
+  DISPATCH(add_avx2(dst, src, size), add_scalar(dst, src, size))
+}
+
+void Simd::add(double *dst, const double *src, std::size_t size) {
+  DISPATCH(add_avx2(dst, src, size), add_scalar(dst, src, size))
+}
+
+void Simd::fill(std::int64_t *data, std::size_t size, std::int64_t val) {
+  DISPATCH(fill_avx2(data, size, val), fill_scalar(data, size, val))
+}
+
+void Simd::fill(double *data, std::size_t size, double val) {
+  DISPATCH(fill_avx2(data, size, val), fill_scalar(data, size, val))
+}
+
+void Simd::convert(const std::int64_t *src, double *dst, std::size_t size) {
+  // AVX2 has no 64 bit integer to double conversion
+  for (std::size_t i = 0; i < size; i++) dst[i] = (double)src[i];
+}
+
+void Simd::sqrt(double *data, std::size_t size) {
+  DISPATCH(sqrt_avx2(data, size), sqrt_scalar(data, size))
+}
+
+void Simd::floor(double *data, std::size_t size) {
+  DISPATCH(floor_avx2(data, size), floor_scalar(data, size))
+}
+
+void Simd::ceil(double *data, std::size_t size) {
+  DISPATCH(ceil_avx2(data, size), ceil_scalar(data, size))
+}
+
+MATH_KERNEL(sin)
+MATH_KERNEL(sinh)
+MATH_KERNEL(cos)
+MATH_KERNEL(cosh)
+MATH_KERNEL(tan)
+MATH_KERNEL(tanh)
+MATH_KERNEL(log)
+MATH_KERNEL(log10)
+MATH_KERNEL(exp)
+MATH_KERNEL(round)
@@ -0,0 +1,46 @@
+#if !defined(__SIMD_)
+#define __SIMD_
+
+#include <cstdint>
+#include <cstddef>
+
+// Whole-array kernels used by the numeric natives.
+// Every kernel has a scalar implementation and an AVX2 one that is picked at runtime when the CPU supports it.
+
+class Simd {
+  public:
+    static bool avx2_supported(void);
+    // reductions
+    static std::int64_t sum(const std::int64_t *data, std::size_t size);
+    static double sum(const double *data, std::size_t size);
+    static std::int64_t min(const std::int64_t *data, std::size_t size);
+    static double min(const double *data, std::size_t size);
+    static std::int64_t max(const std::int64_t *data, std::size_t size);
+    static double max(const double *data, std::size_t size);
+    static std::int64_t dot(const std::int64_t *a, const std::int64_t *b, std::size_t size);
+    static double dot(const double *a, const double *b, std::size_t size);
+    // in place operations
+    static void scale(std::int64_t *data, std::size_t size, std::int64_t factor);
+    static void scale(double *data, std::size_t size, double factor);
+    static void add(std::int64_t *dst, const std::int64_t *src, std::size_t size);
+    static void add(double *dst, const double *src, std::size_t size);
+    static void fill(std::int64_t *data, std::size_t size, std::int64_t val);
+    static void fill(double *data, std::size_t size, double val);
+    static void convert(const std::int64_t *src, double *dst, std::size_t size);
+    // element-wise math, same set as the scalar math natives
+    static void sin(double *data, std::size_t size);
+    static void sinh(double *data, std::size_t size);
+    static void cos(double *data, std::size_t size);
+    static void cosh(double *data, std::size_t size);
+    static void tan(double *data, std::size_t size);
+    static void tanh(double *data, std::size_t size);
+    static void sqrt(double *data, std::size_t size);
+    static void log(double *data, std::size_t size);
+    static void log10(double *data, std::size_t size);
+    static void exp(double *data, std::size_t size);
+    static void floor(double *data, std::size_t size);
+    static void ceil(double *data, std::size_t size);
+    static void round(double *data, std::size_t size);
+};
+
+#endif // __SIMD_
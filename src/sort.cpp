@@ -0,0 +1,71 @@
+#include "sort.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+// every thread gets at least this many elements, otherwise starting it costs more than it saves
+static const std::size_t MIN_CHUNK = 1 << 14;
+
+template <typename T, typename Less>
+static void parallel_sort(T *data, std::size_t size, Less less) {
+  std::size_t chunks = std::min<std::size_t>(std::thread::hardware_concurrency(), size / MIN_CHUNK);
+  if (size < Sort::PARALLEL_THRESHOLD || chunks < 2) {
+    std::sort(data, data + size, less);
+    return;
+  }
+  std::vector<std::size_t> bounds(chunks + 1);
+  for (std::size_t i = 0; i <= chunks; i++) {
+    bounds[i] = size * i / chunks;
+  }
+  std::vector<std::thread> threads;
+  threads.reserve(chunks);
+  for (std::size_t i = 0; i < chunks; i++) {
+    threads.emplace_back([=]() {
+      std::sort(data + bounds[i], data + bounds[i + 1], less);
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  // every round merges neighbouring runs, halving their count
+  for (std::size_t width = 1; width < chunks; width *= 2) {
+    threads.clear();
+    for (std::size_t i = 0; i + width < chunks; i += width * 2) {
+      const std::size_t from = bounds[i];
+      const std::size_t mid = bounds[i + width];
+      const std::size_t to = bounds[std::min(i + width * 2, chunks)];
+      threads.emplace_back([=]() {
+        std::inplace_merge(data + from, data + mid, data + to, less);
+      });
+    }
+    for (auto &thread : threads) thread.join();
+  }
+}
+
+void Sort::ints(std::int64_t *data, std::size_t size) {
+  parallel_sort(data, size, std::less<std::int64_t>());
+}
+
+void Sort::floats(double *data, std::size_t size) {
+  parallel_sort(data, size, [](double a, double b) {
+    return a < b || (std::isnan(b) && !std::isnan(a));
+  });
+}
+
+void Sort::strings(std::vector<Value> &values) {
+  // sort views of the strings and move every value only once, when the sorted order is known
+  std::vector<std::pair<std::string_view, std::uint32_t>> keys(values.size());
+  for (std::size_t i = 0; i < values.size(); i++) {
+    keys[i] = {values[i].string_value.view(), i};
+  }
+  parallel_sort(keys.data(), keys.size(), [](const auto &a, const auto &b) {
+    return a.first < b.first;
+  });
+  std::vector<Value> sorted;
+  sorted.reserve(values.size());
+  for (const auto &key : keys) {
+    sorted.push_back(std::move(values[key.second]));
+  }
+  values.swap(sorted);
+}
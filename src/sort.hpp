@@ -0,0 +1,24 @@
+#if !defined(__SORT_)
+#define __SORT_
+
+#include "CVM.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Sorting of whole arrays for the sort() native.
+// Big inputs are split into one chunk per hardware thread, the chunks are sorted and then merged pairwise in parallel.
+
+class Sort {
+  public:
+    // inputs smaller than this are sorted on the calling thread
+    static constexpr std::size_t PARALLEL_THRESHOLD = 1 << 16;
+    static void ints(std::int64_t *data, std::size_t size);
+    // nan goes last
+    static void floats(double *data, std::size_t size);
+    // by the bytes of the strings
+    static void strings(std::vector<Value> &values);
+};
+
+#endif // __SORT_
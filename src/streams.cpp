@@ -0,0 +1,134 @@
+#include "streams.hpp"
+#include "error-handler.hpp"
+
+RangeStream::RangeStream(std::int64_t from, std::int64_t _to, std::int64_t _step) : current(from), to(_to), step(_step) {
+  element_type = "int";
+}
+
+bool RangeStream::next(Value &out) {
+  if (done || (step > 0 ? current >= to : current <= to)) return false;
+  // a for each loop passes the same variable every time, only the number changes
+  if (out.type != Utils::INT) out = Value(Utils::INT);
+  out.number_value = current;
+  // stepping past the end of the int range ends the stream instead of wrapping
+  if (__builtin_add_overflow(current, step, &current)) done = true;
+  return true;
+}
+
+ArrayStream::ArrayStream(const Value &_arr) : arr(_arr) {
+  element_type = arr.array_type;
+}
+
+bool ArrayStream::next(Value &out) {
+  if (index >= arr.array_size()) return false;
+  out = arr.array_at(index++);
+  return true;
+}
+
+LinesStream::LinesStream(const std::string &path) : reader(path) {
+  element_type = "str";
+}
+
+bool LinesStream::next(Value &out) {
+  std::string_view line;
+  std::shared_ptr<const void> owner;
+  if (!reader.next(line, owner)) return false;
+  out = Value(Utils::STR);
+  out.string_value = SharedString(owner, line);
+  return true;
+}
+
+// rebinding would destroy the caller of the function that is running
+static void check_reentry(const std::unique_ptr<FunctionCaller> &caller, std::int64_t line) {
+  if (caller != nullptr && caller->busy()) {
+    ErrorHandler::throw_runtime_error("a stream can't be consumed from inside one of its own functions", line);
+  }
+}
+
+void CallbackStream::bind(Evaluator *evaluator, std::int64_t _line) {
+  check_reentry(caller, _line);
+  line = _line;
+  source->bind(evaluator, _line);
+  caller = evaluator == nullptr ? nullptr : std::make_unique<FunctionCaller>(*evaluator, fn);
+}
+
+MapStream::MapStream(const std::shared_ptr<Stream> &_source, const Value &_fn) : CallbackStream(_source, _fn) {
+  element_type = fn.func.ret_type;
+}
+
+bool MapStream::next(Value &out) {
+  if (!source->next(element)) return false;
+  const Value *args[] = {&element};
+  out = caller->call(args);
+  return true;
+}
+
+FilterStream::FilterStream(const std::shared_ptr<Stream> &_source, const Value &_fn) : CallbackStream(_source, _fn) {
+  element_type = source->element_type;
+}
+
+bool FilterStream::next(Value &out) {
+  while (source->next(out)) {
+    const Value *args[] = {&out};
+    const Value keep = caller->call(args);
+    if (keep.type != Utils::BOOL) {
+      ErrorHandler::throw_runtime_error("stream_filter() expects a function that returns a bool", line);
+    }
+    if (keep.boolean_value) return true;
+  }
+  return false;
+}
+
+TakeStream::TakeStream(const std::shared_ptr<Stream> &_source, std::int64_t count) : source(_source), left(count) {
+  element_type = source->element_type;
+}
+
+// stops pulling from the source once it has enough, so an endless source is fine
+bool TakeStream::next(Value &out) {
+  if (left <= 0) return false;
+  left--;
+  return source->next(out);
+}
+
+SkipStream::SkipStream(const std::shared_ptr<Stream> &_source, std::int64_t count) : source(_source), skip(count) {
+  element_type = source->element_type;
+}
+
+bool SkipStream::next(Value &out) {
+  for (; skip > 0; skip--) {
+    if (!source->next(out)) return false;
+  }
+  return source->next(out);
+}
+
+ZipStream::ZipStream(const std::shared_ptr<Stream> &_first, const std::shared_ptr<Stream> &_second, const Value &_fn) :
+  first(_first),
+  second(_second),
+  fn(_fn) {
+  element_type = fn.type == Utils::FUNC ? Symbol(fn.func.ret_type) : Symbol("arr");
+}
+
+bool ZipStream::next(Value &out) {
+  if (!first->next(a) || !second->next(b)) return false;
+  if (caller != nullptr) {
+    const Value *args[] = {&a, &b};
+    out = caller->call(args);
+    return true;
+  }
+  if (a.type != b.type) {
+    ErrorHandler::throw_runtime_error("stream_zip() without a function expects elements of the same type", line);
+  }
+  out = Value(Utils::ARR);
+  out.set_array_type(first->element_type);
+  out.array_push(a);
+  out.array_push(b);
+  return true;
+}
+
+void ZipStream::bind(Evaluator *evaluator, std::int64_t _line) {
+  check_reentry(caller, _line);
+  line = _line;
+  first->bind(evaluator, _line);
+  second->bind(evaluator, _line);
+  caller = evaluator == nullptr || fn.type != Utils::FUNC ? nullptr : std::make_unique<FunctionCaller>(*evaluator, fn);
+}
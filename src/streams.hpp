@@ -0,0 +1,115 @@
+#if !defined(__STREAMS_)
+#define __STREAMS_
+
+#include "CVM.hpp"
+#include "evaluator.hpp"
+#include "files.hpp"
+
+#include <cstdint>
+#include <memory>
+
+// Lazy streams.
+// A stream is a chain of sources and adapters that hands out one element at a time when a terminal pulls it,
+// so a pipeline runs in a single pass without building arrays between the steps.
+// Streams are handles like the containers and can only be consumed once.
+
+class Stream {
+  public:
+    // declared type of the elements, used by collect
+    Symbol element_type;
+    // line of the terminal that consumes the stream, for errors
+    std::int64_t line = 0;
+    virtual ~Stream() {};
+    // stores the next element in out, returns false when the stream is exhausted
+    virtual bool next(Value &out) = 0;
+    // functions of adapters are called through the evaluator of the terminal that consumes the stream
+    virtual void bind(Evaluator *caller, std::int64_t _line) { line = _line; };
+};
+
+class RangeStream : public Stream {
+  private:
+    std::int64_t current, to, step;
+    bool done = false;
+  public:
+    RangeStream(std::int64_t from, std::int64_t _to, std::int64_t _step);
+    bool next(Value &out);
+};
+
+class ArrayStream : public Stream {
+  private:
+    const Value arr;
+    std::size_t index = 0;
+  public:
+    ArrayStream(const Value &_arr);
+    bool next(Value &out);
+};
+
+// lines are views into the chunk they were read with
+class LinesStream : public Stream {
+  private:
+    LineReader reader;
+  public:
+    LinesStream(const std::string &path);
+    bool good(void) const { return reader.good(); }
+    bool next(Value &out);
+};
+
+// base of the adapters that call a Ckript function
+class CallbackStream : public Stream {
+  protected:
+    std::shared_ptr<Stream> source;
+    const Value fn;
+    std::unique_ptr<FunctionCaller> caller;
+  public:
+    CallbackStream(const std::shared_ptr<Stream> &_source, const Value &_fn) : source(_source), fn(_fn) {};
+    void bind(Evaluator *evaluator, std::int64_t _line);
+};
+
+class MapStream : public CallbackStream {
+  private:
+    Value element;
+  public:
+    MapStream(const std::shared_ptr<Stream> &_source, const Value &_fn);
+    bool next(Value &out);
+};
+
+class FilterStream : public CallbackStream {
+  public:
+    FilterStream(const std::shared_ptr<Stream> &_source, const Value &_fn);
+    bool next(Value &out);
+};
+
+class TakeStream : public Stream {
+  private:
+    std::shared_ptr<Stream> source;
+    std::int64_t left;
+  public:
+    TakeStream(const std::shared_ptr<Stream> &_source, std::int64_t count);
+    bool next(Value &out);
+    void bind(Evaluator *caller, std::int64_t _line) { source->bind(caller, _line); }
+};
+
+class SkipStream : public Stream {
+  private:
+    std::shared_ptr<Stream> source;
+    std::int64_t skip;
+  public:
+    SkipStream(const std::shared_ptr<Stream> &_source, std::int64_t count);
+    bool next(Value &out);
+    void bind(Evaluator *caller, std::int64_t _line) { source->bind(caller, _line); }
+};
+
+// pairs up the elements of two streams, into two element arrays or through a function
+class ZipStream : public Stream {
+  private:
+    std::shared_ptr<Stream> first, second;
+    const Value fn;
+    std::unique_ptr<FunctionCaller> caller;
+    Value a, b;
+  public:
+    ZipStream(const std::shared_ptr<Stream> &_first, const std::shared_ptr<Stream> &_second, const Value &_fn);
+    bool next(Value &out);
+    void bind(Evaluator *evaluator, std::int64_t _line);
+};
+
+#endif // __STREAMS_
@@ -0,0 +1,138 @@
+#include "strings.hpp"
+
+#include <unordered_set>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cctype>
+
+// nodes of an unordered_set never move, so the addresses handed out stay valid
+static std::unordered_set<std::string> &table(void) {
+  static std::unordered_set<std::string> strings;
+  return strings;
+}
+
+const std::string *InternTable::intern(const std::string &str) {
+  auto &strings = table();
+  auto it = strings.find(str);
+  if (it == strings.end()) {
+    it = strings.insert(str).first;
+  }
+  return &*it;
+}
+
+// interned strings are never freed, so the handle doesn't need to own them
+SharedString::SharedString(void) : buffer(std::shared_ptr<const std::string>(), InternTable::empty()) {}
+
+SharedString::SharedString(const Symbol &sym) : buffer(std::shared_ptr<const std::string>(), sym.address()) {}
+
+SharedString::SharedString(const SharedString &parent, std::size_t from, std::size_t length) :
+  buffer(parent.buffer),
+  view_data(parent.view().data() + from),
+  view_length(length),
+  is_view(true) {}
+
+SharedString::SharedString(const std::shared_ptr<const void> &owner, std::string_view data) :
+  buffer(owner, InternTable::empty()),
+  view_data(data.data()),
+  view_length(data.size()),
+  is_view(true) {}
+
+void SharedString::materialize(void) const {
+  buffer = std::make_shared<std::string>(view());
+  view_data = nullptr;
+  is_view = false;
+}
+
+std::string &SharedString::mut() {
+  if (is_view || buffer.use_count() != 1) {
+    materialize();
+  }
+  // a unique buffer was created by make_shared<std::string>, so it isn't really const
+  return const_cast<std::string &>(*buffer);
+}
+
+StringTemplate::StringTemplate(std::string_view _text) : text(_text) {
+  std::size_t literal_start = 0;
+  for (std::size_t i = 0; i < text.size(); i++) {
+    if (text[i] != '@' || i + 1 == text.size() || text[i + 1] < '1' || text[i + 1] > '9') continue;
+    if (i != literal_start) {
+      segments.push_back({literal_start, i - literal_start, false});
+      literal_size += i - literal_start;
+    }
+    std::size_t digits_end = i + 1;
+    while (digits_end < text.size() && text[digits_end] >= '0' && text[digits_end] <= '9') {
+      digits_end++;
+    }
+    segments.push_back({i + 1, digits_end - i - 1, true});
+    literal_start = digits_end;
+    i = digits_end - 1;
+  }
+  if (literal_start != text.size()) {
+    segments.push_back({literal_start, text.size() - literal_start, false});
+    literal_size += text.size() - literal_start;
+  }
+}
+
+// @n takes the longest run of digits that names an argument, so with two arguments @12 is the first one and a 2
+// runs that don't name any argument stay in the output as they are
+std::string StringTemplate::format(const std::vector<std::string> &args) const {
+  std::size_t size = literal_size;
+  for (const auto &arg : args) {
+    size += arg.size();
+  }
+  std::string res;
+  res.reserve(size);
+  for (const auto &segment : segments) {
+    if (!segment.placeholder) {
+      res.append(text.data() + segment.offset, segment.length);
+      continue;
+    }
+    std::size_t index = 0, used = 0;
+    for (; used < segment.length; used++) {
+      const std::size_t next = index * 10 + (text[segment.offset + used] - '0');
+      if (next > args.size()) break;
+      index = next;
+    }
+    if (used == 0) {
+      res.push_back('@');
+    } else {
+      res.append(args[index - 1]);
+    }
+    res.append(text.data() + segment.offset + used, segment.length - used);
+  }
+  return res;
+}
+
+void append_number(std::string &out, std::int64_t value) {
+  char digits[24];
+  const auto res = std::to_chars(digits, digits + sizeof(digits), value);
+  out.append(digits, res.ptr);
+}
+
+void append_number(std::string &out, double value) {
+  char digits[32];
+  const auto res = std::to_chars(digits, digits + sizeof(digits), value);
+  out.append(digits, res.ptr);
+  if (std::isfinite(value) && std::find_if(digits, res.ptr, [](char c) { return c == '.' || c == 'e'; }) == res.ptr) {
+    out += ".0";
+  }
+}
+
+template <typename T>
+static bool parse_whole(std::string_view text, T &out, bool dot) {
+  // from_chars doesn't take a leading +, so it is skipped, but only when a number follows it
+  if (text.size() > 1 && text[0] == '+' && (std::isdigit((unsigned char)text[1]) || (dot && text[1] == '.'))) {
+    text.remove_prefix(1);
+  }
+  const auto res = std::from_chars(text.data(), text.data() + text.size(), out);
+  return !text.empty() && res.ec == std::errc() && res.ptr == text.data() + text.size();
+}
+
+bool parse_number(std::string_view text, std::int64_t &out) {
+  return parse_whole(text, out, false);
+}
+
+bool parse_number(std::string_view text, double &out) {
+  return parse_whole(text, out, true);
+}
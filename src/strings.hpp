@@ -0,0 +1,133 @@
+#if !defined(__STRINGS_)
+#define __STRINGS_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Interned and shared strings.
+// Names and string literals are interned once in a table that lives as long as the interpreter,
+// so every Value referring to them only carries a pointer and can be compared by address.
+
+class InternTable {
+  public:
+    static const std::string *intern(const std::string &str);
+    static const std::string *empty(void) {
+      static const std::string *const empty_str = intern("");
+      return empty_str;
+    }
+};
+
+// immutable handle to an interned name (identifiers, members, class and type names)
+class Symbol {
+  private:
+    const std::string *ptr;
+  public:
+    Symbol(void) : ptr(InternTable::empty()) {};
+    Symbol(const std::string &str) : ptr(InternTable::intern(str)) {};
+    Symbol(const char *str) : ptr(InternTable::intern(str)) {};
+    const std::string &str() const { return *ptr; }
+    operator const std::string &() const { return *ptr; }
+    const std::string *address() const { return ptr; }
+    std::size_t size() const { return ptr->size(); }
+    bool empty() const { return ptr->empty(); }
+    const char *c_str() const { return ptr->c_str(); }
+    // interned, so equal names always share an address
+    bool operator==(const Symbol &other) const { return ptr == other.ptr; }
+    bool operator!=(const Symbol &other) const { return ptr != other.ptr; }
+    bool operator<(const Symbol &other) const { return ptr != other.ptr && *ptr < *other.ptr; }
+};
+
+// string value storage, copies share one buffer and only copy it when it's mutated
+// a view is a range of another string's buffer, it's copied out when it's mutated or needs to be null terminated
+// views can also point into memory that isn't a std::string (mapped files), buffer only keeps it alive then
+class SharedString {
+  private:
+    mutable std::shared_ptr<const std::string> buffer;
+    mutable const char *view_data = nullptr;
+    mutable std::size_t view_length = 0;
+    mutable bool is_view = false;
+    void materialize(void) const;
+  public:
+    SharedString(void);
+    SharedString(const Symbol &sym);
+    SharedString(const std::string &str) : buffer(std::make_shared<std::string>(str)) {};
+    SharedString(const char *str) : buffer(std::make_shared<std::string>(str)) {};
+    SharedString(const SharedString &parent, std::size_t from, std::size_t length);
+    // view of data that stays valid as long as owner is alive
+    SharedString(const std::shared_ptr<const void> &owner, std::string_view data);
+    std::string_view view() const {
+      return is_view ? std::string_view(view_data, view_length) : std::string_view(*buffer);
+    }
+    const std::string &str() const {
+      if (is_view) materialize();
+      return *buffer;
+    }
+    operator const std::string &() const { return str(); }
+    std::string &mut();
+    std::size_t size() const { return is_view ? view_length : buffer->size(); }
+    std::size_t length() const { return size(); }
+    bool empty() const { return size() == 0; }
+    const char *c_str() const { return str().c_str(); }
+    const char *data() const { return view().data(); }
+    std::size_t find(std::string_view str, std::size_t pos = 0) const { return view().find(str, pos); }
+    char operator[](std::size_t index) const { return view()[index]; }
+    bool same_buffer(const SharedString &other) const { return buffer == other.buffer; }
+    // interned buffers aren't owned by any handle and live as long as the interpreter
+    bool interned() const { return !is_view && buffer.use_count() == 0; }
+    const std::string *address() const { return buffer.get(); }
+    bool operator==(const SharedString &other) const {
+      if (same_buffer(other) && is_view == other.is_view && view_data == other.view_data && size() == other.size()) {
+        return true;
+      }
+      return view() == other.view();
+    }
+    bool operator!=(const SharedString &other) const { return !(*this == other); }
+};
+
+// a string called like a function ("@1 is @2"(name, age)), split once into literal text and placeholders
+// the text has to outlive the template, the interpreter only caches templates of interned strings
+class StringTemplate {
+  private:
+    class Segment {
+      public:
+        std::size_t offset;
+        std::size_t length;
+        // placeholders keep the digits after the @
+        bool placeholder;
+    };
+    std::string_view text;
+    std::vector<Segment> segments;
+    std::size_t literal_size = 0;
+  public:
+    StringTemplate(std::string_view _text);
+    std::string format(const std::vector<std::string> &args) const;
+};
+
+// numbers as print() and to_str() show them, formatted with to_chars straight into out
+// doubles get the shortest text that reads back as the same value, with a .0 if it would look like an int
+void append_number(std::string &out, std::int64_t value);
+void append_number(std::string &out, double value);
+
+// the whole text has to be the number, a + is only taken in front of a digit (or a '.' for doubles)
+bool parse_number(std::string_view text, std::int64_t &out);
+bool parse_number(std::string_view text, double &out);
+
+// concatenation with plain strings, mostly for error messages
+inline std::string operator+(const std::string &lhs, const Symbol &rhs) { return lhs + rhs.str(); }
+inline std::string operator+(const Symbol &lhs, const std::string &rhs) { return lhs.str() + rhs; }
+inline std::string operator+(const char *lhs, const Symbol &rhs) { return lhs + rhs.str(); }
+inline std::string operator+(const Symbol &lhs, const char *rhs) { return lhs.str() + rhs; }
+inline std::string operator+(const std::string &lhs, const SharedString &rhs) { return std::string(lhs).append(rhs.view()); }
+inline std::string operator+(const SharedString &lhs, const std::string &rhs) { return std::string(lhs.view()).append(rhs); }
+inline std::string operator+(const char *lhs, const SharedString &rhs) { return std::string(lhs).append(rhs.view()); }
+inline std::string operator+(const SharedString &lhs, const char *rhs) { return std::string(lhs.view()).append(rhs); }
+
+inline std::ostream &operator<<(std::ostream &os, const Symbol &sym) { return os << sym.str(); }
+inline std::ostream &operator<<(std::ostream &os, const SharedString &str) { return os << str.view(); }
+
+#endif // __STRINGS_
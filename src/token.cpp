@@ -17,6 +17,9 @@ std::string Token::get_name(TokenType type) {
   REG(TYPE, "type");
   REG(REF, "ref");
   REG(CONST, "const");
+  REG(SWITCH, "switch");
+  REG(CASE, "case");
+  REG(DEFAULT, "default");
   REG(STRING_LITERAL, "string");
   REG(DECIMAL, "decimal number");
   REG(FLOAT, "floating point number");
@@ -23,6 +23,7 @@ class Token {
 
       FUNCTION = 130, RETURN, IF, ELSE, BREAK, CONTINUE,
       FOR, WHILE, ALLOC, DEL, TYPE, REF, CONST,
+      SWITCH, CASE, DEFAULT,
 
       STRING_LITERAL, DECIMAL, FLOAT, HEX, OCTAL, BINARY, ARRAY, CLASS,
 
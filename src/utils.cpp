@@ -40,7 +40,7 @@ Utils::Utils(void) {
   REG(OP_MOD, 11); // %
   REG(DOT, 13); // .
   REG(LEFT_BRACKET, 13); // []
-  var_lut.reserve(9);
+  var_lut.reserve(17);
   var_lut["double"] = FLOAT;
   var_lut["int"] = INT;
   var_lut["str"] = STR;
@@ -50,6 +50,14 @@ Utils::Utils(void) {
   var_lut["func"] = FUNC;
   var_lut["class"] = CLASS;
   var_lut["void"] = VOID;
+  var_lut["builder"] = BUILDER;
+  var_lut["map"] = MAP;
+  var_lut["hashset"] = SET;
+  var_lut["omap"] = OMAP;
+  var_lut["deque"] = DEQUE;
+  var_lut["pqueue"] = PQUEUE;
+  var_lut["stream"] = STREAM;
+  var_lut["regex"] = REGEX;
 }
 
 bool Utils::has_key(Token::TokenType key) {
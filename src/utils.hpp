@@ -9,7 +9,7 @@
 class Utils {
   public:
     typedef enum var_type {
-      INT, FLOAT, STR, ARR, OBJ, BOOL, FUNC, REF, ID, VOID, CLASS, UNKNOWN
+      INT, FLOAT, STR, ARR, OBJ, BOOL, FUNC, REF, ID, VOID, CLASS, BUILDER, MAP, SET, OMAP, DEQUE, PQUEUE, STREAM, REGEX, UNKNOWN
     } VarType;
     bool op_binary(Token::TokenType token);
     bool op_unary(Token::TokenType token);